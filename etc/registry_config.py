@@ -28,6 +28,7 @@ entropy_coders = [
 consuming_entropy_coders = [
     AlgorithmConfig(name="ArithmeticCoder", header="coders/ArithmeticCoder.hpp"),
     AlgorithmConfig(name="SLECoder", header="coders/SLECoder.hpp"),
+    AlgorithmConfig(name="ANSCoder", header="coders/ANSCoder.hpp"),
 ]
 
 # All non-consuming coders
@@ -43,6 +44,17 @@ sa = [
     AlgorithmConfig(name="SADivSufSort", header="ds/SADivSufSort.hpp"),
 ]
 
+# Parallel Suffix Array (not combined with data structures that are
+# templated on the suffix array type)
+sa_parallel = [
+    AlgorithmConfig(name="SAParallel", header="ds/SAParallel.hpp"),
+]
+
+# Suffix Array stored on disk
+sa_external = [
+    AlgorithmConfig(name="SAExternal", header="ds/SAExternal.hpp"),
+]
+
 # Phi Array
 phi = [
     AlgorithmConfig(name="PhiFromSA", header="ds/PhiFromSA.hpp"),
@@ -53,25 +65,41 @@ plcp = [
     AlgorithmConfig(name="PLCPFromPhi", header="ds/PLCPFromPhi.hpp"),
 ]
 
+# PLCP Array stored on disk
+plcp_external = [
+    AlgorithmConfig(name="PLCPExternal", header="ds/PLCPExternal.hpp"),
+]
+
 # Uncompressed LCP Array
 lcp_uncompressed = [
     AlgorithmConfig(name="LCPFromPLCP", header="ds/LCPFromPLCP.hpp"),
 ]
 
+# LCP Array stored on disk
+lcp_external = [
+    AlgorithmConfig(name="LCPExternal", header="ds/LCPExternal.hpp"),
+]
+
 # All LCP Arrays
 lcp = lcp_uncompressed + [
     AlgorithmConfig(name="CompressedLCP", header="ds/CompressedLCP.hpp", sub=[sa]),
 ]
 
-# Inverse Suffix Array
-isa = [
+# Uncompressed Inverse Suffix Array
+isa_uncompressed = [
     AlgorithmConfig(name="ISAFromSA", header="ds/ISAFromSA.hpp"),
+]
+
+# Inverse Suffix Array
+isa = isa_uncompressed + [
     AlgorithmConfig(name="SparseISA", header="ds/SparseISA.hpp", sub=[sa]),
 ]
 
 # TextDS
 textds = [
     AlgorithmConfig(name="TextDS", header="ds/TextDS.hpp", sub=[sa, phi, plcp, lcp, isa]),
+    AlgorithmConfig(name="TextDS", header="ds/TextDS.hpp", sub=[sa_parallel, phi, plcp, lcp_uncompressed, isa_uncompressed]),
+    AlgorithmConfig(name="TextDS", header="ds/TextDS.hpp", sub=[sa_external, phi, plcp_external, lcp_external, isa_uncompressed]),
 ]
 
 ##### lz78 #####
@@ -139,6 +167,7 @@ lcpcomp_coders = [
     AlgorithmConfig(name="ASCIICoder", header="coders/ASCIICoder.hpp"),
     AlgorithmConfig(name="SLECoder", header="coders/SLECoder.hpp"),
     AlgorithmConfig(name="HuffmanCoder", header="coders/HuffmanCoder.hpp"),
+    AlgorithmConfig(name="ANSCoder", header="coders/ANSCoder.hpp"),
 ]
 
 # lcpcomp factorization strategies ("comp")
@@ -161,17 +190,20 @@ lcpcomp_dec = [
     AlgorithmConfig(name="lcpcomp::DecodeForwardQueueListBuffer", header="compressors/lcpcomp/decompress/DecodeQueueListBuffer.hpp"),
     AlgorithmConfig(name="lcpcomp::CompactDec", header="compressors/lcpcomp/decompress/CompactDec.hpp"),
     AlgorithmConfig(name="lcpcomp::MultimapBuffer", header="compressors/lcpcomp/decompress/MultiMapBuffer.hpp"),
+    AlgorithmConfig(name="lcpcomp::ParallelDec", header="compressors/lcpcomp/decompress/ParallelDec.hpp"),
 ]
 
 # Allowed TextDS instances for lcpcomp (LCP array must be writable!)
 lcpcomp_textds = [
     AlgorithmConfig(name="TextDS", header="ds/TextDS.hpp", sub=[sa, phi, plcp, lcp_uncompressed, isa]),
+    AlgorithmConfig(name="TextDS", header="ds/TextDS.hpp", sub=[sa_parallel, phi, plcp, lcp_uncompressed, isa_uncompressed]),
 ]
 
 ##### ESP grammar compressor WIP #####
 ipd = [
     AlgorithmConfig(name="esp::StdUnorderedMapIPD", header="compressors/esp/StdUnorderedMapIPD.hpp"),
     AlgorithmConfig(name="esp::HashMapIPD", header="compressors/esp/HashMapIPD.hpp"),
+    AlgorithmConfig(name="esp::CompactIPD", header="compressors/esp/CompactIPD.hpp"),
 ]
 
 ipddyn = ipd + [
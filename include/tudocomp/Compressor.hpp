@@ -1,7 +1,9 @@
 #pragma once
 
+#include <algorithm>
 #include <functional>
 #include <memory>
+#include <vector>
 
 #include <tudocomp/pre_header/Registry.hpp>
 #include <tudocomp/pre_header/Env.hpp>
@@ -40,6 +42,33 @@ public:
     /// \param input The input.
     /// \param output The output.
     virtual void decompress(Input& input, Output& output) = 0;
+
+    /// \brief Decompress only a substring of the original input.
+    ///
+    /// Writes the \c len characters starting at position \c from of the
+    /// original input to the output, or less if the input ends before.
+    ///
+    /// The default implementation decompresses the whole input into memory.
+    /// Compressors that can access their compressed representation
+    /// randomly override this.
+    ///
+    /// \param input The input.
+    /// \param output The output.
+    /// \param from The position of the first character to decompress.
+    /// \param len The amount of characters to decompress.
+    virtual void extract(Input& input, Output& output, size_t from, size_t len) {
+        std::vector<uint8_t> buffer;
+        {
+            Output buffer_output(buffer);
+            decompress(input, buffer_output);
+        }
+
+        if(from < buffer.size()) {
+            len = std::min(len, buffer.size() - from);
+            auto ostream = output.as_stream();
+            ostream.write((const char*) buffer.data() + from, len);
+        }
+    }
 };
 
 }
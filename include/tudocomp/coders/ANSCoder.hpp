@@ -0,0 +1,371 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <vector>
+
+#include <tudocomp/Coder.hpp>
+#include <tudocomp/util.hpp>
+
+namespace tdc {
+
+/// \cond INTERNAL
+namespace ans {
+
+    /// The precision of the symbol probabilities in bits.
+    constexpr size_t PROB_BITS = 12;
+    constexpr uint32_t PROB_SCALE = uint32_t(1) << PROB_BITS;
+    constexpr uint32_t PROB_MASK = PROB_SCALE - 1;
+
+    /// The lower bound of the coder states, which are kept in [L, L << 16).
+    constexpr uint32_t STATE_LOW = uint32_t(1) << 16;
+
+    /// The amount of interleaved coder states.
+    constexpr size_t STATES = 2;
+
+    /// The context for literals.
+    constexpr size_t LITERAL_CTX = 0;
+    /// The context for bits.
+    constexpr size_t BIT_CTX = 1;
+    /// The context for integers of a range of w bits is BIT_CTX + w.
+    constexpr size_t NUM_CTX = BIT_CTX + 65;
+
+    /// Values of ranges up to this bit width are coded as symbols directly,
+    /// larger ones are binned by their bit width.
+    constexpr size_t MAX_DIRECT_BITS = 8;
+
+    /// The maximum amount of symbols in a context.
+    constexpr size_t MAX_SYMBOLS = 256;
+
+    /// Returns the context for values in range r.
+    inline size_t range_ctx(const Range& r) {
+        return BIT_CTX + bits_for(r.max() - r.min());
+    }
+
+    /// Returns whether values in context ctx are binned.
+    inline bool is_binned(size_t ctx) {
+        return ctx > BIT_CTX + MAX_DIRECT_BITS;
+    }
+
+    /// The frequencies of the symbols of a context, normalized to sum up
+    /// to PROB_SCALE.
+    struct model {
+        std::array<uint16_t, MAX_SYMBOLS> freq;
+        std::array<uint16_t, MAX_SYMBOLS> start;
+        size_t num_symbols = 0;
+
+        /// Computes start from freq.
+        inline void accumulate() {
+            uint32_t sum = 0;
+            for(size_t s = 0; s < num_symbols; ++s) {
+                start[s] = sum;
+                sum += freq[s];
+            }
+            DCHECK_EQ(sum, PROB_SCALE);
+        }
+
+        /// Normalizes symbol counts to frequencies.
+        inline void normalize(const uint32_t* count, size_t n) {
+            num_symbols = n;
+
+            uint64_t total = 0;
+            for(size_t s = 0; s < n; ++s) total += count[s];
+            DCHECK_GT(total, 0U);
+
+            int64_t sum = 0;
+            for(size_t s = 0; s < n; ++s) {
+                freq[s] = (count[s] == 0) ? 0 :
+                    std::max(uint64_t(1), uint64_t(count[s]) * PROB_SCALE / total);
+                sum += freq[s];
+            }
+
+            // correct rounding errors at the most frequent symbols,
+            // every occurring symbol keeps a frequency of at least one
+            int64_t diff = int64_t(PROB_SCALE) - sum;
+            while(diff != 0) {
+                size_t best = 0;
+                for(size_t s = 1; s < n; ++s) {
+                    if(freq[s] > freq[best]) best = s;
+                }
+                if(diff > 0) {
+                    freq[best] += diff;
+                    diff = 0;
+                } else {
+                    const int64_t take = std::min(-diff, int64_t(freq[best]) - 1);
+                    freq[best] -= take;
+                    diff += take;
+                }
+            }
+            accumulate();
+        }
+    };
+
+    /// A model with a lookup table from probability slots to symbols.
+    struct decode_model : public model {
+        std::unique_ptr<uint8_t[]> slot_symbol;
+
+        inline void build_slots() {
+            accumulate();
+            slot_symbol = std::make_unique<uint8_t[]>(PROB_SCALE);
+            for(size_t s = 0; s < num_symbols; ++s) {
+                std::fill(slot_symbol.get() + start[s],
+                          slot_symbol.get() + start[s] + freq[s], uint8_t(s));
+            }
+        }
+    };
+
+}
+/// \endcond
+
+/// \brief Static rANS entropy coder.
+///
+/// Literals, bits and range values are coded with separate models. Values
+/// of ranges up to 256 values are coded directly, larger ones are binned by
+/// their bit width, with the bits following the leading one stored plainly.
+///
+/// The symbols are buffered and coded in blocks. The frequencies of each
+/// model are counted per block and stored in its header, followed by the
+/// output of two interleaved rANS states and the plainly stored bits.
+class ANSCoder : public Algorithm {
+public:
+    inline static Meta meta() {
+        Meta m("coder", "ans", "Static rANS coder with interleaved states");
+        m.option("block").dynamic(1 << 20);
+        return m;
+    }
+
+    ANSCoder() = delete;
+
+    class Encoder : public tdc::Encoder {
+        struct symbol_t {
+            uint8_t ctx;
+            uint8_t sym;
+        };
+
+        size_t m_block_size;
+        std::vector<symbol_t> m_symbols;
+        std::vector<uint64_t> m_extra; // the plain bits of binned values
+
+        inline void push(size_t ctx, size_t sym) {
+            m_symbols.push_back(symbol_t { uint8_t(ctx), uint8_t(sym) });
+            if(m_symbols.size() == m_block_size) flush();
+        }
+
+        inline void flush() {
+            using namespace ans;
+            if(m_symbols.empty()) return;
+
+            // count symbols
+            std::vector<std::array<uint32_t, MAX_SYMBOLS>> count(NUM_CTX);
+            std::vector<size_t> num_symbols(NUM_CTX, 0);
+            for(auto& count_ctx : count) count_ctx.fill(0);
+            for(auto& x : m_symbols) {
+                ++count[x.ctx][x.sym];
+                num_symbols[x.ctx] = std::max(num_symbols[x.ctx], size_t(x.sym) + 1);
+            }
+
+            // write block header and models
+            m_out->write_compressed_int(m_symbols.size());
+
+            std::vector<model> models(NUM_CTX);
+            const size_t used = NUM_CTX - std::count(num_symbols.begin(), num_symbols.end(), 0U);
+            m_out->write_compressed_int(used);
+            for(size_t ctx = 0; ctx < NUM_CTX; ++ctx) {
+                if(num_symbols[ctx] == 0) continue;
+
+                models[ctx].normalize(count[ctx].data(), num_symbols[ctx]);
+                m_out->write_compressed_int(ctx);
+                m_out->write_compressed_int(num_symbols[ctx] - 1);
+                for(size_t s = 0; s < num_symbols[ctx]; ++s) {
+                    m_out->write_elias_gamma(models[ctx].freq[s] + 1U);
+                }
+            }
+
+            // encode symbols in reverse order
+            std::array<uint32_t, STATES> state;
+            state.fill(STATE_LOW);
+            std::vector<uint16_t> words;
+            for(size_t i = m_symbols.size(); i > 0; --i) {
+                const symbol_t& x = m_symbols[i - 1];
+                const model& m = models[x.ctx];
+                const uint32_t freq = m.freq[x.sym];
+                uint32_t& s = state[(i - 1) % STATES];
+
+                const uint64_t s_max = uint64_t((STATE_LOW >> PROB_BITS) << 16) * freq;
+                if(s >= s_max) {
+                    words.push_back(uint16_t(s));
+                    s >>= 16;
+                }
+                s = ((s / freq) << PROB_BITS) + (s % freq) + m.start[x.sym];
+            }
+
+            // write states and words in the order they are decoded
+            m_out->write_compressed_int(words.size());
+            for(auto s : state) m_out->write_int(s, 32);
+            for(size_t i = words.size(); i > 0; --i) {
+                m_out->write_int(words[i - 1], 16);
+            }
+
+            // write plain bits of binned values
+            size_t j = 0;
+            for(auto& x : m_symbols) {
+                if(is_binned(x.ctx) && x.sym > 1) {
+                    m_out->write_int(m_extra[j++], x.sym - 1);
+                }
+            }
+            DCHECK_EQ(j, m_extra.size());
+
+            m_symbols.clear();
+            m_extra.clear();
+        }
+
+    public:
+        template<typename literals_t>
+        inline Encoder(Env&& env, std::shared_ptr<BitOStream> out, literals_t&& literals)
+            : tdc::Encoder(std::move(env), out, literals) {
+
+            m_block_size = std::max(size_t(1),
+                size_t(this->env().option("block").as_integer()));
+        }
+
+        template<typename literals_t>
+        inline Encoder(Env&& env, Output& out, literals_t&& literals)
+            : Encoder(std::move(env), std::make_shared<BitOStream>(out), literals) {
+        }
+
+        ~Encoder() {
+            flush();
+            m_out->write_compressed_int(0); // terminator
+        }
+
+        template<typename value_t>
+        inline void encode(value_t v, const Range& r) {
+            const size_t ctx = ans::range_ctx(r);
+            const uint64_t x = uint64_t(v) - uint64_t(r.min());
+
+            if(ans::is_binned(ctx)) {
+                const size_t bin = (x == 0) ? 0 : bits_for(x);
+                if(bin > 1) m_extra.push_back(x ^ (uint64_t(1) << (bin - 1)));
+                push(ctx, bin);
+            } else {
+                push(ctx, x);
+            }
+        }
+
+        template<typename value_t>
+        inline void encode(value_t v, const LiteralRange&) {
+            push(ans::LITERAL_CTX, uliteral_t(v));
+        }
+
+        template<typename value_t>
+        inline void encode(value_t v, const BitRange&) {
+            push(ans::BIT_CTX, v ? 1 : 0);
+        }
+    };
+
+    class Decoder : public tdc::Decoder {
+        std::vector<ans::decode_model> m_models;
+
+        size_t m_block_size = 0;
+        size_t m_index = 0;
+
+        std::array<uint32_t, ans::STATES> m_state;
+        std::vector<uint16_t> m_words;
+        size_t m_word_pos = 0;
+
+        inline void read_block() {
+            using namespace ans;
+
+            m_index = 0;
+            m_block_size = m_in->eof() ? 0 : m_in->read_compressed_int<size_t>();
+            if(m_block_size == 0) return;
+
+            const size_t used = m_in->read_compressed_int<size_t>();
+            for(size_t i = 0; i < used; ++i) {
+                const size_t ctx = m_in->read_compressed_int<size_t>();
+                CHECK_LT(ctx, NUM_CTX) << "corrupted ANS block header";
+
+                decode_model& m = m_models[ctx];
+                m.num_symbols = m_in->read_compressed_int<size_t>() + 1;
+                for(size_t s = 0; s < m.num_symbols; ++s) {
+                    m.freq[s] = m_in->read_elias_gamma<size_t>() - 1;
+                }
+                m.build_slots();
+            }
+
+            const size_t num_words = m_in->read_compressed_int<size_t>();
+            for(auto& s : m_state) s = m_in->read_int<uint32_t>(32);
+            m_words.resize(num_words);
+            for(auto& w : m_words) w = m_in->read_int<uint16_t>(16);
+            m_word_pos = 0;
+        }
+
+        inline size_t decode_symbol(size_t ctx) {
+            using namespace ans;
+            DCHECK_LT(m_index, m_block_size);
+
+            const decode_model& m = m_models[ctx];
+            DCHECK(m.slot_symbol) << "no model for context " << ctx;
+
+            uint32_t& s = m_state[m_index % STATES];
+            const uint32_t slot = s & PROB_MASK;
+            const uint8_t sym = m.slot_symbol[slot];
+            s = m.freq[sym] * (s >> PROB_BITS) + slot - m.start[sym];
+            if(s < STATE_LOW) {
+                // a single word suffices, since the state is at least 16
+                s = (s << 16) | m_words[m_word_pos++];
+            }
+            ++m_index;
+            return sym;
+        }
+
+        /// Proceeds to the next block when the current one is done.
+        inline void next() {
+            if(m_index == m_block_size) read_block();
+        }
+
+    public:
+        inline Decoder(Env&& env, std::shared_ptr<BitIStream> in)
+            : tdc::Decoder(std::move(env), in), m_models(ans::NUM_CTX) {
+            read_block();
+        }
+
+        inline Decoder(Env&& env, Input& in)
+            : Decoder(std::move(env), std::make_shared<BitIStream>(in)) {
+        }
+
+        inline bool eof() const {
+            return m_block_size == 0;
+        }
+
+        template<typename value_t>
+        inline value_t decode(const Range& r) {
+            const size_t ctx = ans::range_ctx(r);
+            const size_t sym = decode_symbol(ctx);
+
+            uint64_t x = sym;
+            if(ans::is_binned(ctx) && sym > 0) {
+                x = (uint64_t(1) << (sym - 1)) | m_in->read_int<uint64_t>(sym - 1);
+            }
+            next();
+            return value_t(uint64_t(r.min()) + x);
+        }
+
+        template<typename value_t>
+        inline value_t decode(const LiteralRange&) {
+            const value_t v = value_t(uliteral_t(decode_symbol(ans::LITERAL_CTX)));
+            next();
+            return v;
+        }
+
+        template<typename value_t>
+        inline value_t decode(const BitRange&) {
+            const value_t v = value_t(decode_symbol(ans::BIT_CTX));
+            next();
+            return v;
+        }
+    };
+};
+
+}
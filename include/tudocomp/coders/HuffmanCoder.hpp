@@ -1,6 +1,8 @@
 #pragma once
 
+#include <algorithm>
 #include <bitset>
+#include <memory>
 #include <numeric>
 
 #include <tudocomp/Env.hpp>
@@ -374,26 +376,104 @@ namespace huff {
             DVLOG(2) << "prefix_sum_lengths : " << arr_to_debug_string(prefix_sum_lengths.get(), longest);
             return prefix_sum_lengths;
     }
-    inline uliteral_t huffman_decode(
+    /** The amount of bits looked up at once by the table-driven decoder.
+     */
+    constexpr uint8_t DECODE_TABLE_BITS = 11;
+
+    /** An entry of the decode table, storing the codewords starting with a
+     * sequence of DECODE_TABLE_BITS bits.
+     * length[0] is the length of the first codeword, or 0 if it is longer than DECODE_TABLE_BITS.
+     * length[1] is the total length of the first two codewords, or 0 if the second does not fit.
+     */
+    struct decode_entry {
+        uliteral_t symbol[2];
+        uint8_t length[2];
+    };
+
+    /**
+     * Lookup table that maps the next bits of the input to the codewords they start with.
+     * Needed for decoding Huffman code
+     */
+    struct decode_table {
+        uint8_t bits; //! the amount of bits looked up, at most DECODE_TABLE_BITS
+        std::unique_ptr<decode_entry[]> entries;
+    };
+
+    inline decode_table gen_decode_table(
+            const uliteral_t*const ordered_map_from_effective,
+            const size_t*const prefix_sum_lengths,
+            const size_t*const firstcodes,
+            const uint8_t longest) {
+        const uint8_t bits = std::min(longest, DECODE_TABLE_BITS);
+        decode_table table { bits, std::make_unique<decode_entry[]>(size_t(1) << bits) };
+
+        // finds the codeword at the beginning of the highest n bits of code,
+        // returns its length or 0 if it is longer than n
+        auto resolve = [&] (const size_t code, const uint8_t n, uliteral_t& symbol) -> uint8_t {
+            for(uint8_t length = 1; length <= n; ++length) {
+                const size_t value = code >> (bits - length);
+                if(value >= firstcodes[length-1]) {
+                    symbol = ordered_map_from_effective[prefix_sum_lengths[length-1] + (value - firstcodes[length-1])];
+                    return length;
+                }
+            }
+            return 0;
+        };
+
+        const size_t mask = (size_t(1) << bits) - 1;
+        for(size_t code = 0; code <= mask; ++code) {
+            decode_entry& entry = table.entries[code];
+            entry.length[0] = resolve(code, bits, entry.symbol[0]);
+            entry.length[1] = 0;
+            if(entry.length[0] > 0 && entry.length[0] < bits) {
+                const uint8_t second = resolve((code << entry.length[0]) & mask, bits - entry.length[0], entry.symbol[1]);
+                if(second > 0) entry.length[1] = entry.length[0] + second;
+            }
+        }
+        return table;
+    }
+
+    /**
+     * Decodes the codewords that are longer than the table lookup.
+     * The input is positioned after the first length bits of the codeword, whose value is given by value.
+     */
+    inline uliteral_t huffman_decode_long(
             tdc::io::BitIStream& is,
+            size_t value,
+            uint8_t length,
             const uliteral_t*const ordered_map_from_effective,
             const size_t*const prefix_sum_lengths,
             const size_t*const firstcodes
             ) {
-        DCHECK(!is.eof());
-        size_t value = 0;
-        uint8_t length = 0;
-        do {
+        while(value < firstcodes[length-1]) {
             DCHECK(!is.eof());
             value = (value<<1) + is.read_bit();
             ++length;
-        } while(value < firstcodes[length-1]);
+        }
         DVLOG(2) << " codeword " << value << " length " << length;
         --length;
-//      DCHECK_LT(prefix_sum_lengths[length]+ (value - firstcodes[length]), alphabet_size);
         return ordered_map_from_effective[prefix_sum_lengths[length]+ (value - firstcodes[length]) ];
+    }
 
-
+    /**
+     * Decodes a single literal
+     */
+    inline uliteral_t huffman_decode(
+            tdc::io::BitIStream& is,
+            const uliteral_t*const ordered_map_from_effective,
+            const size_t*const prefix_sum_lengths,
+            const size_t*const firstcodes,
+            const decode_table& table
+            ) {
+        DCHECK(!is.eof());
+        const size_t code = is.peek_int<size_t>(table.bits);
+        const decode_entry& entry = table.entries[code];
+        if(tdc_likely(entry.length[0] > 0)) {
+            is.skip_bits(entry.length[0]);
+            return entry.symbol[0];
+        }
+        is.skip_bits(table.bits);
+        return huffman_decode_long(is, code, table.bits, ordered_map_from_effective, prefix_sum_lengths, firstcodes);
     }
 
 
@@ -412,11 +492,25 @@ namespace huff {
             DCHECK_GT(text_length, 0);
             const size_t*const firstcodes = gen_first_codes(numl, longest);
             DVLOG(2) << "firstcodes : " << arr_to_debug_string(firstcodes, longest);
+            const decode_table table = gen_decode_table(ordered_map_from_effective, prefix_sum_lengths.get(), firstcodes, longest);
+
             size_t num_chars_read = 0;
-            while(true) {
-                output << huffman_decode(is, ordered_map_from_effective, prefix_sum_lengths.get(), firstcodes);
-                ++num_chars_read;
-                if(num_chars_read == text_length) break;
+            // resolve two codewords per table lookup where possible
+            while(num_chars_read + 1 < text_length) {
+                const size_t code = is.peek_int<size_t>(table.bits);
+                const decode_entry& entry = table.entries[code];
+                if(entry.length[1] > 0) {
+                    is.skip_bits(entry.length[1]);
+                    output.put(entry.symbol[0]);
+                    output.put(entry.symbol[1]);
+                    num_chars_read += 2;
+                } else {
+                    output.put(huffman_decode(is, ordered_map_from_effective, prefix_sum_lengths.get(), firstcodes, table));
+                    ++num_chars_read;
+                }
+            }
+            if(num_chars_read < text_length) {
+                output.put(huffman_decode(is, ordered_map_from_effective, prefix_sum_lengths.get(), firstcodes, table));
             }
             delete [] firstcodes;
     }
@@ -573,6 +667,7 @@ public:
         const uliteral_t* ordered_map_from_effective;
         std::unique_ptr<size_t const[]> prefix_sum_lengths;
         const size_t* firstcodes;
+        huff::decode_table m_decode_table;
     public:
         ~Decoder() {
             if(tdc_likely(ordered_map_from_effective != nullptr)) {
@@ -595,6 +690,7 @@ public:
             prefix_sum_lengths = huff::gen_prefix_sum_lengths(ordered_codelengths, table.alphabet_size, table.longest);
             delete [] ordered_codelengths;
             firstcodes = huff::gen_first_codes(table.numl, table.longest);
+            m_decode_table = huff::gen_decode_table(ordered_map_from_effective, prefix_sum_lengths.get(), firstcodes, table.longest);
         }
 
         inline Decoder(Env&& env, Input& in)
@@ -607,7 +703,7 @@ public:
         inline value_t decode(const LiteralRange&) {
             if(tdc_unlikely(ordered_map_from_effective == nullptr))
                 return m_in->read_int<uliteral_t>();
-            return huff::huffman_decode(*m_in, ordered_map_from_effective, prefix_sum_lengths.get(), firstcodes);
+            return huff::huffman_decode(*m_in, ordered_map_from_effective, prefix_sum_lengths.get(), firstcodes, m_decode_table);
         }
     };
 };
@@ -1,8 +1,13 @@
 #pragma once
 
+#include <algorithm>
+#include <vector>
+
 #include <tudocomp/util.hpp>
 #include <tudocomp/Compressor.hpp>
 #include <tudocomp/ds/bwt.hpp>
+#include <tudocomp/ds/BlockwiseBWT.hpp>
+#include <tudocomp/ds/InverseBWT.hpp>
 #include <tudocomp/ds/TextDS.hpp>
 #include <tudocomp/util.hpp>
 
@@ -10,16 +15,32 @@
 
 namespace tdc {
 
+/// Computes the Burrows-Wheeler transform of the input.
+///
+/// With `construction = "sa"`, the BWT is read off the suffix array of the
+/// text data structure. With `construction = "blockwise"`, the suffixes are
+/// sorted in blocks without a suffix array (see \ref bwt::blockwise_bwt),
+/// which needs far less memory but more time.
+///
+/// The BWT is decoded without an LF array by `threads` threads (0 for one
+/// per hardware thread, see \ref bwt::inverse_bwt).
 template<typename text_t = TextDS<>>
 class BWTCompressor : public Compressor {
 
 private:
 //    const TypeRange<len_t> len_r = TypeRange<len_t>();
 
+    static constexpr size_t BWT_CHUNK_SIZE = 1ull << 16;
+
+    // the amount of blocks of the blockwise construction
+    static constexpr size_t BWT_BLOCKS = 16;
+
 public:
     inline static Meta meta() {
         Meta m("compressor", "bwt", "BWT Compressor");
         m.option("textds").templated<text_t, TextDS<>>("textds");
+        m.option("construction").dynamic("sa");
+        m.option("threads").dynamic(0);
         m.uses_textds<text_t>(ds::SA);
         return m;
     }
@@ -31,6 +52,19 @@ public:
         auto in = input.as_view();
         DCHECK(in.ends_with(uint8_t(0)));
 
+        const std::string construction = env().option("construction").as_string();
+        CHECK(construction == "sa" || construction == "blockwise")
+            << "unknown BWT construction: " << construction;
+
+        if(construction == "blockwise") {
+            StatPhase::wrap("Blockwise BWT", [&]{
+                bwt::blockwise_bwt(in, BWT_BLOCKS, [&](View chunk) {
+                    ostream.write(chunk);
+                });
+            });
+            return;
+        }
+
         text_t t(env().env_for_option("textds"), in, text_t::SA);
 		DVLOG(2) << vec_to_debug_string(t);
 		const len_t input_size = t.size();
@@ -40,9 +74,17 @@ public:
             DVLOG(2) << vec_to_debug_string(t.require_sa());
         });
 
+        // the BWT is written in chunks
+        const size_t chunk_size = std::min(size_t(input_size), size_t(BWT_CHUNK_SIZE));
+        std::vector<uliteral_t> chunk(chunk_size);
+
         const auto& sa = t.require_sa();
-        for(size_t i = 0; i < input_size; ++i) {
-            ostream << bwt::bwt(t,sa,i);
+        for(size_t i = 0; i < input_size; i += chunk_size) {
+            const size_t n = std::min(chunk_size, input_size - i);
+            for(size_t j = 0; j < n; ++j) {
+                chunk[j] = bwt::bwt(t,sa,i+j);
+            }
+            ostream.write(View(chunk.data(), n));
         }
     }
 
@@ -50,17 +92,17 @@ public:
         auto in = input.as_view();
         auto ostream = output.as_stream();
 
-		auto decoded_string = StatPhase::wrap("Decode BWT", [&]{
-            return bwt::decode_bwt(in);
-        });
-
-		if(tdc_unlikely(decoded_string.empty())) {
-			return;
-		}
+        if(tdc_unlikely(in.size() <= 1)) {
+            return;
+        }
 
-        StatPhase::wrap("Output Text", [&]{
-            ostream << decoded_string << '\0';
+        const size_t threads = env().option("threads").as_integer();
+        StatPhase::wrap("Decode BWT", [&]{
+            bwt::inverse_bwt(in, threads, [&](View chunk) {
+                ostream.write(chunk);
+            });
         });
+        ostream << '\0';
     }
 };
 
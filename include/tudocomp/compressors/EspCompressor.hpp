@@ -5,6 +5,7 @@
 #include <tudocomp_stat/StatPhase.hpp>
 
 #include <tudocomp/util.hpp>
+#include <tudocomp/util/parallel.hpp>
 #include <tudocomp/Env.hpp>
 #include <tudocomp/Compressor.hpp>
 #include <tudocomp/ds/IntVector.hpp>
@@ -17,6 +18,15 @@
 
 namespace tdc {
 
+/// Computes a grammar of the input using edit sensitive parsing (ESP).
+///
+/// The rounds of the parsing can be computed by multiple `threads`
+/// (0 for one per hardware thread), which split the string of each round
+/// into independent chunks and deduplicate the blocks concurrently.
+/// The grammar does not depend on the amount of threads.
+///
+/// Substrings of the text can be extracted from the grammar without
+/// deriving the whole text, see \ref esp::SLP::extract.
 template<typename slp_coder_t, typename ipd_t = esp::StdUnorderedMapIPD>
 class EspCompressor: public Compressor {
 public:
@@ -24,6 +34,7 @@ public:
         Meta m("compressor", "esp", "ESP based grammar compression");
         m.option("slp_coder").templated<slp_coder_t, esp::PlainSLPCoder>("slp_coder");
         m.option("ipd").templated<ipd_t, esp::StdUnorderedMapIPD>("ipd");
+        m.option("threads").dynamic(1);
         return m;
     }
 
@@ -35,6 +46,8 @@ public:
         auto phase0 = StatPhase("ESP Compressor");
 
         EspContext<ipd_t> context { &env(), true };
+        context.threads = env().option("threads").as_integer();
+        if (context.threads == 0) context.threads = hardware_threads();
         SLP slp;
 
         {
@@ -87,6 +100,30 @@ public:
                 out << ""_v;
             }
     }
+
+    /// Decodes the grammar and derives only the requested part of the text,
+    /// descending from the start rule using the expansion lengths of the
+    /// rules.
+    ///
+    /// Decoding the grammar and computing the expansion lengths take time
+    /// linear in the size of the grammar, after which the derivation takes
+    /// time linear in the height of the grammar plus `len`.
+    inline virtual void extract(Input& input, Output& output,
+                                size_t from, size_t len) override {
+        auto phase0 = StatPhase("ESP Extract");
+
+        auto phase1 = StatPhase("Creating strategy");
+            const slp_coder_t strategy { this->env().env_for_option("slp_coder") };
+        phase1.split("Decode SLP");
+            auto slp = strategy.decode(input);
+
+        phase1.split("Compute expansion lengths");
+            auto lengths = slp.expansion_lengths();
+
+        phase1.split("Derive text");
+            auto out = output.as_stream();
+            slp.extract(out, from, len, lengths);
+    }
 };
 
 }
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstring>
+#include <vector>
+
 #include <tudocomp/Compressor.hpp>
 #include <tudocomp/compressors/lz78/LZ78Trie.hpp>
 #include <tudocomp/Range.hpp>
@@ -13,28 +16,43 @@
 namespace tdc {
 
     namespace lz78 {
+        /// Decodes LZ78 factors into a buffer holding the whole text.
+        ///
+        /// Since the phrases are stored consecutively in the text, a phrase
+        /// is identified by its starting position. Decoding a factor copies
+        /// the referenced phrase in one go.
         class Decompressor {
-            std::vector<lz78::factorid_t> indices;
-            std::vector<uliteral_t> literals;
+            std::vector<uliteral_t> m_text;
+            std::vector<size_t> m_starts; // starting position of each phrase
 
             public:
-            inline void decompress(lz78::factorid_t index, uliteral_t literal, std::ostream& out) {
-                indices.push_back(index);
-                literals.push_back(literal);
-                std::vector<uliteral_t> buffer;
-
-                while(index != 0) {
-                    buffer.push_back(literal);
-                    literal = literals[index - 1];
-                    index = indices[index - 1];
-                }
+            inline Decompressor(size_t reserve = 0) {
+                m_text.reserve(reserve);
+            }
+
+            inline void decompress(lz78::factorid_t index, uliteral_t literal) {
+                const size_t pos = m_text.size();
+                m_starts.push_back(pos);
 
-                out << literal;
-                for(size_t i = buffer.size(); i > 0; i--) {
-                    out << buffer[i - 1];
+                if(index == 0) {
+                    m_text.push_back(literal);
+                    return;
                 }
+
+                // the referenced phrase ends where the next one starts
+                DCHECK_LT(index, m_starts.size());
+                const size_t start = m_starts[index - 1];
+                const size_t len = m_starts[index] - start;
+
+                m_text.resize(pos + len + 1);
+                std::memcpy(m_text.data() + pos, m_text.data() + start, len);
+                m_text[pos + len] = literal;
             }
 
+            /// The decoded text.
+            inline const std::vector<uliteral_t>& text() const {
+                return m_text;
+            }
         };
     }//ns
 
@@ -62,8 +80,10 @@ public:
     }
 
     virtual void compress(Input& input, Output& out) override {
-        const size_t n = input.size();
-        const size_t reserved_size = isqrt(n)*2;
+        // the size is only a hint, unknown for inputs read from a pipe
+        const size_t size_hint = input.size_hint();
+        const size_t n = (size_hint == Input::npos) ? lz78::UNKNOWN_TEXT_SIZE : size_hint;
+        const size_t reserved_size = (size_hint == Input::npos) ? 0 : isqrt(n)*2;
         auto is = input.as_stream();
 
         // Stats
@@ -141,18 +161,20 @@ public:
 
     virtual void decompress(Input& input, Output& output) override final {
         auto out = output.as_stream();
+        const size_t size_hint = input.size_hint();
+        lz78::Decompressor decomp((size_hint == Input::npos) ? 0 : size_hint);
         typename coder_t::Decoder decoder(env().env_for_option("coder"), input);
 
-        lz78::Decompressor decomp;
         uint64_t factor_count = 0;
 
         while (!decoder.eof()) {
             const lz78::factorid_t index = decoder.template decode<lz78::factorid_t>(Range(factor_count));
             const uliteral_t chr = decoder.template decode<uliteral_t>(literal_r);
-            decomp.decompress(index, chr, out);
+            decomp.decompress(index, chr);
             factor_count++;
         }
 
+        out.write((const char*) decomp.text().data(), decomp.text().size());
         out.flush();
     }
 
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstring>
+#include <vector>
+
 #include <tudocomp/Compressor.hpp>
 
 #include <sdsl/cst_fully.hpp>
@@ -21,68 +24,64 @@ namespace lz78u {
 
     // TODO: Define factorid for lz78u uniformly
 
+    /// Decodes LZ78U factors into a buffer holding the whole text.
+    ///
+    /// Since the phrases are stored consecutively in the text, a phrase
+    /// is identified by its starting position. Decoding a factor copies
+    /// the referenced phrase in one go.
     class Decompressor {
         std::vector<lz78::factorid_t> indices;
-        std::vector<uliteral_t> literal_strings;
-        std::vector<size_t> start_literal_strings;
+        std::vector<size_t> starts; // starting position of each phrase
+        std::vector<uliteral_t> text;
 
-        std::vector<uliteral_t> buffer;
+        inline size_t end_at(lz78::factorid_t index) const {
+            return (size_t(index) < starts.size()) ? starts[index] : text.size();
+        }
 
         public:
+        inline Decompressor(size_t reserve = 0) {
+            text.reserve(reserve);
+        }
+
         inline lz78::factorid_t ref_at(lz78::factorid_t index) const {
             DCHECK_NE(index, 0);
             size_t i = index - 1;
             return indices[i];
         }
+
+        /// The literal string that the phrase appends to its reference.
         inline View str_at(lz78::factorid_t index) const {
             DCHECK_NE(index, 0);
-            size_t i = index - 1;
-            View ls = literal_strings;
-
-            size_t start = start_literal_strings[i];
-            size_t end = 0;
-            if ((i + 1) < start_literal_strings.size()) {
-                end = start_literal_strings[i + 1];
-            } else {
-                end = ls.size();
-            }
-
-            return ls.slice(start, end);
+            const lz78::factorid_t ref = ref_at(index);
+            const size_t ref_len = (ref == 0) ? 0 : end_at(ref) - starts[ref - 1];
+            return View(text).slice(starts[index - 1] + ref_len, end_at(index));
         }
 
-        inline void decompress(lz78::factorid_t index, View literals, std::ostream& out) {
-            indices.push_back(index);
-            start_literal_strings.push_back(literal_strings.size());
-            for (auto c : literals) {
-                literal_strings.push_back(c);
-            }
-
-            //std::cout << "    indices:         " << vec_to_debug_string(indices) << "\n";
-            //std::cout << "    start lit str:   " << vec_to_debug_string(start_literal_strings) << "\n";
-            //std::cout << "    literal_strings: " << vec_to_debug_string(literal_strings) << "\n";
-
-            buffer.clear();
-
-            while(true) {
-                auto inv_old_size = buffer.size();
-                for (size_t i = 0; i < literals.size(); i++) {
-                    buffer.push_back(literals[literals.size() - i - 1]);
-                }
-
-                DCHECK_EQ(inv_old_size + literals.size(), buffer.size());
+        /// The whole phrase.
+        inline View phrase_at(lz78::factorid_t index) const {
+            DCHECK_NE(index, 0);
+            return View(text).slice(starts[index - 1], end_at(index));
+        }
 
-                if (index == 0) {
-                    break;
-                }
-                literals = str_at(index);
-                index = ref_at(index);
+        inline void decompress(lz78::factorid_t index, View literals) {
+            const size_t pos = text.size();
+            size_t len = 0;
+            if (index != 0) {
+                const size_t start = starts[index - 1];
+                len = end_at(index) - start;
+                text.resize(pos + len);
+                std::memcpy(text.data() + pos, text.data() + start, len);
             }
 
-            std::reverse(buffer.begin(), buffer.end());
-            //std::cout << "    reconstructed: " << vec_to_debug_string(buffer) << "\n";
-            out << buffer;
+            indices.push_back(index);
+            starts.push_back(pos);
+            text.insert(text.end(), literals.begin(), literals.end());
         }
 
+        /// The decoded text.
+        inline const std::vector<uliteral_t>& decoded() const {
+            return text;
+        }
     };
 }
 
@@ -275,6 +274,11 @@ public:
         DVLOG(2) << "[ decompress ]";
         auto out = output.as_stream();
 
+        // the size is only a hint, and it must be queried before the
+        // input is taken as a stream
+        const size_t size_hint = input.size_hint();
+        lz78u::Decompressor decomp((size_hint == Input::npos) ? 0 : size_hint);
+
         {
             DecompressionStrat strategy {
                 env().env_for_option("comp"),
@@ -284,8 +288,6 @@ public:
 
             uint64_t factor_count = 0;
 
-            lz78u::Decompressor decomp;
-
             std::vector<uliteral_t> rebuilt_buffer;
 
             while (!strategy.eof()) {
@@ -304,7 +306,7 @@ public:
                         << "' '"
                         << str
                         << "'";
-                    decomp.decompress(ref, str, out);
+                    decomp.decompress(ref, str);
                 } else {
                     // rebuild the factorized string label
                     rebuilt_buffer.clear();
@@ -331,24 +333,9 @@ public:
                                     --cut;
                                 }
                             } else {
-                                size_t prev_r = sub_ref;
-                                size_t old_end = rebuilt_buffer.size();
-
-                                // push the chars in reverse order
-                                // to allow efficient appending of prefixes
-                                do {
-                                    View s = decomp.str_at(prev_r);
-                                    prev_r = decomp.ref_at(prev_r);
-
-                                    for (size_t j = 0; j < s.size(); j++) {
-                                        rebuilt_buffer.push_back(s[s.size() - j - 1]);
-                                    }
-                                } while (prev_r != 0);
-                                DCHECK_EQ(prev_r, 0);
-
-                                // reverse suffix containing the new string fragment
-                                std::reverse(rebuilt_buffer.begin() + old_end,
-                                             rebuilt_buffer.end());
+                                View s = decomp.phrase_at(sub_ref);
+                                rebuilt_buffer.insert(rebuilt_buffer.end(),
+                                                      s.begin(), s.end());
                             }
                         }
 
@@ -362,7 +349,7 @@ public:
                         << ((ref > 0) ? decomp.str_at(ref) : ""_v)
                         << "' '"
                         << rebuilt_buffer << "'";
-                    decomp.decompress(ref, rebuilt_buffer, out);
+                    decomp.decompress(ref, rebuilt_buffer);
                 }
 
                 /*
@@ -373,6 +360,8 @@ public:
 
                 factor_count++;
             }
+
+            out.write((const char*) decomp.decoded().data(), decomp.decoded().size());
         }
 
         out << '\0';
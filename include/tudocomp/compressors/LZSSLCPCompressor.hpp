@@ -2,16 +2,19 @@
 
 #include <algorithm>
 #include <functional>
+#include <string>
 #include <vector>
 
 #include <tudocomp/Compressor.hpp>
 #include <tudocomp/Range.hpp>
 #include <tudocomp/util.hpp>
+#include <tudocomp/util/parallel.hpp>
 
 #include <tudocomp/compressors/lzss/LZSSFactors.hpp>
 #include <tudocomp/compressors/lzss/LZSSLiterals.hpp>
 #include <tudocomp/compressors/lzss/LZSSCoding.hpp>
 
+#include <tudocomp/ds/IntVector.hpp>
 #include <tudocomp/ds/TextDS.hpp>
 
 #include <tudocomp_stat/StatPhase.hpp>
@@ -20,14 +23,332 @@ namespace tdc {
 
 /// Computes the LZ77 factorization of the input using its suffix array and
 /// LCP table.
+///
+/// The longest previous factor at a text position is the one shared with
+/// its previous or next smaller value (PSV / NSV) in the suffix array. The
+/// `strategy` option selects how these are found:
+///
+/// - `psv_nsv` (default) precomputes bit-packed PSV and NSV arrays indexed
+///   by text position in a single pass over the suffix array and compares
+///   the text against both candidates. This takes linear time and requires
+///   neither the inverse suffix array nor the LCP array.
+/// - `lean` converts the Phi array in-place to the PSV array and computes
+///   the NSV on the fly during the parse. The suffix array is discarded as
+///   soon as Phi is built, so only a single integer array of n entries
+///   exists at any time besides the text.
+/// - `naive` scans the suffix and LCP arrays from the current position
+///   until a smaller value is found, which can take quadratic time on
+///   repetitive texts.
+///
+/// All strategies produce the same factorization.
+///
+/// With the `psv_nsv` strategy, the factorization can be computed by
+/// multiple `threads` (0 for one per hardware thread) using the PSV and NSV
+/// arrays built once. The `lean` strategy always parses sequentially.
 template<typename coder_t, typename text_t = TextDS<>>
 class LZSSLCPCompressor : public Compressor {
+private:
+    /// The amount of text segments parsed per thread in parallel mode.
+    static constexpr size_t SEGMENTS_PER_THREAD = 4;
+
+    /// Factorizes by scanning the suffix and LCP arrays for the PSV and NSV
+    /// of each factor's suffix.
+    inline static void factorize_naive(text_t& text, const len_t threshold,
+                                       lzss::FactorBuffer& factors) {
+        auto& sa = text.require_sa();
+        auto& isa = text.require_isa();
+        auto& lcp = text.require_lcp();
+
+        const len_t text_length = text.size();
+
+        for(len_t i = 0; i+1 < text_length;) { // we omit T[text_length-1] since we assume that it is the \0 byte!
+            //get SA position for suffix i
+            const size_t& cur_pos = isa[i];
+            DCHECK_NE(cur_pos,0); // isa[i] == 0 <=> T[i] = 0
+
+            //compute naively PSV
+            //search "upwards" in LCP array
+            //include current, exclude last
+            size_t psv_lcp = lcp[cur_pos];
+            ssize_t psv_pos = cur_pos - 1;
+            if (psv_lcp > 0) {
+                while (psv_pos >= 0 && sa[psv_pos] > sa[cur_pos]) {
+                    psv_lcp = std::min<size_t>(psv_lcp, lcp[psv_pos--]);
+                }
+            }
+
+            //compute naively NSV
+            //search "downwards" in LCP array
+            //exclude current, include last
+            size_t nsv_lcp = 0;
+            size_t nsv_pos = cur_pos + 1;
+            if (nsv_pos < text_length) {
+                nsv_lcp = SSIZE_MAX;
+                do {
+                    nsv_lcp = std::min<size_t>(nsv_lcp, lcp[nsv_pos]);
+                    if (sa[nsv_pos] < sa[cur_pos]) {
+                        break;
+                    }
+                } while (++nsv_pos < text_length);
+
+                if (nsv_pos >= text_length) {
+                    nsv_lcp = 0;
+                }
+            }
+
+            //select maximum
+            const size_t& max_lcp = std::max(psv_lcp, nsv_lcp);
+            if(max_lcp >= threshold) {
+                const ssize_t& max_pos = max_lcp == psv_lcp ? psv_pos : nsv_pos;
+                DCHECK_LT(max_pos, text_length);
+                DCHECK_GE(max_pos, 0);
+                // new factor
+                factors.emplace_back(i, sa[max_pos], max_lcp);
+
+                i += max_lcp; //advance
+            } else {
+                ++i; //advance
+            }
+        }
+    }
+
+    /// Factorizes using PSV and NSV arrays indexed by text position, where
+    /// `undef` marks a missing smaller value.
+    ///
+    /// With multiple threads, the text is split into segments that are
+    /// parsed greedily and independently. The parses are then stitched
+    /// together from left to right: starting at the first position of the
+    /// final parse in a segment, factors are computed sequentially until a
+    /// position is reached at which the segment's parse starts a phrase,
+    /// from where on both parses coincide. The result is the same as that
+    /// of a sequential parse.
+    template<typename psv_t, typename nsv_t>
+    inline static void factorize_with(const text_t& text,
+                                      const psv_t& psv, const nsv_t& nsv,
+                                      const size_t undef, const len_t threshold,
+                                      const size_t threads,
+                                      lzss::FactorBuffer& factors) {
+        // we omit T[text_length-1] since we assume that it is the \0 byte!
+        const size_t n = text.size() - 1;
+
+        // the text ends with a unique \0, so comparisons stop in the text
+        auto lcp = [&](size_t a, size_t b) {
+            size_t l = 0;
+            while(text[a + l] == text[b + l]) ++l;
+            return l;
+        };
+
+        // parses from position i to the first phrase beginning at or after
+        // end, passing each factor to emit, and returns that position
+        auto parse = [&](size_t i, const size_t end, auto emit) {
+            while(i < end) {
+                const size_t psv_pos = psv[i];
+                const size_t nsv_pos = nsv[i];
+                const size_t psv_lcp = (psv_pos != undef) ? lcp(psv_pos, i) : 0;
+                const size_t nsv_lcp = (nsv_pos != undef) ? lcp(nsv_pos, i) : 0;
+
+                //select maximum
+                const size_t max_lcp = std::max(psv_lcp, nsv_lcp);
+                if(max_lcp >= threshold) {
+                    const size_t max_pos = max_lcp == psv_lcp ? psv_pos : nsv_pos;
+                    DCHECK_LT(max_pos, i);
+                    // new factor
+                    emit(i, max_pos, max_lcp);
+
+                    i += max_lcp; //advance
+                } else {
+                    ++i; //advance
+                }
+            }
+            return i;
+        };
+
+        auto emit_global = [&](size_t pos, size_t src, size_t len) {
+            factors.emplace_back(pos, src, len);
+        };
+
+        const size_t segments = std::min(n, SEGMENTS_PER_THREAD * threads);
+        if(threads <= 1 || segments <= 1) {
+            parse(0, n, emit_global);
+            return;
+        }
+
+        std::vector<size_t> bounds(segments + 1);
+        for(size_t k = 0; k <= segments; ++k) {
+            bounds[k] = n * k / segments;
+        }
+
+        std::vector<std::vector<lzss::Factor>> seg_factors(segments);
+        std::vector<size_t> seg_end(segments);
+
+        parallel_for(segments, threads, [&](size_t k) {
+            auto& f = seg_factors[k];
+            seg_end[k] = parse(bounds[k], bounds[k+1],
+                [&](size_t pos, size_t src, size_t len) {
+                    f.emplace_back(pos, src, len);
+                });
+        });
+
+        // stitch the segments
+        size_t pos = 0;
+        size_t recomputed = 0;
+        for(size_t k = 0; k < segments; ++k) {
+            const auto& f = seg_factors[k];
+
+            while(pos < bounds[k+1]) {
+                // find the factor of the segment covering pos, if any
+                auto it = std::upper_bound(f.begin(), f.end(), pos,
+                    [](size_t p, const lzss::Factor& x) { return p < x.pos; });
+
+                const bool inside = (it != f.begin()) &&
+                    (std::prev(it)->pos < pos) &&
+                    (pos < size_t(std::prev(it)->pos) + std::prev(it)->len);
+
+                if(!inside) {
+                    // the parses coincide from here on
+                    if(it != f.begin() && std::prev(it)->pos == pos) --it;
+                    for(; it != f.end(); ++it) {
+                        factors.emplace_back(it->pos, it->src, it->len);
+                    }
+                    pos = seg_end[k];
+                    break;
+                }
+
+                // compute one step of the final parse
+                const size_t next = parse(pos, pos + 1, emit_global);
+                recomputed += next - pos;
+                pos = next;
+            }
+        }
+
+        StatPhase::log("segments", segments);
+        StatPhase::log("recomputed", recomputed);
+    }
+
+    /// Factorizes using PSV and NSV arrays computed from the suffix array.
+    inline static void factorize_psv_nsv(text_t& text, const len_t threshold,
+                                         const size_t threads,
+                                         lzss::FactorBuffer& factors) {
+        const len_t text_length = text.size();
+        const size_t undef = text_length; // no smaller value
+
+        // psv[j] and nsv[j] are the text positions of the previous and next
+        // smaller value of suffix j in the suffix array
+        DynamicIntVector psv(text_length, undef, bits_for(undef));
+        DynamicIntVector nsv(text_length, undef, bits_for(undef));
+
+        StatPhase::wrap("PSV/NSV", [&]{
+            auto& sa = text.require_sa();
+
+            // the suffixes on the stack of increasing values are linked
+            // by their psv entries
+            size_t top = undef;
+            for(size_t k = 0; k < text_length; ++k) {
+                const size_t j = sa[k];
+                while(top != undef && top > j) {
+                    nsv[top] = j;
+                    top = psv[top];
+                }
+                psv[j] = top;
+                top = j;
+            }
+        });
+
+        factorize_with(text, psv, nsv, undef, threshold, threads, factors);
+    }
+
+    /// Factorizes using a single integer array that is obtained in-place
+    /// from the Phi array. The suffix array is discarded as soon as Phi is
+    /// built, so besides the text only n integers are held at any time.
+    ///
+    /// The PSV and NSV of a position i are the lexicographic predecessor and
+    /// successor of suffix i among the suffixes starting before i. Hence,
+    /// inserting the suffixes in text order into a list sorted
+    /// lexicographically, suffix i is inserted right after its PSV and the
+    /// NSV is the successor of the PSV before the insertion. The array
+    /// entry of a position holds its PSV until the position is inserted and
+    /// its list successor afterwards, so the NSV is computed on the fly
+    /// during a sequential parse.
+    inline static void factorize_lean(text_t& text, const len_t threshold,
+                                      lzss::FactorBuffer& factors) {
+        const len_t text_length = text.size();
+        const size_t undef = text_length; // no smaller value
+
+        // phi[j] is the suffix preceding suffix j in the suffix array
+        auto psv = text.inplace_phi(CompressMode::compressed);
+        text.release_sa();
+
+        StatPhase::wrap("PSV", [&]{
+            // Phi wraps around at the \0 suffix, which precedes all others
+            psv[text_length - 1] = undef;
+
+            // The PSV of j is the first position smaller than j in the chain
+            // phi[j], psv[phi[j]], ..., which only consists of larger
+            // positions that have been processed before.
+            for(size_t j = text_length - 1; j-- > 0;) {
+                size_t p = psv[j];
+                while(p != undef && p > j) p = psv[p];
+                psv[j] = p;
+            }
+        });
+
+        // we omit T[text_length-1] since we assume that it is the \0 byte!
+        const size_t n = text_length - 1;
+
+        // the text ends with a unique \0, so comparisons stop in the text
+        auto lcp = [&](size_t a, size_t b) {
+            size_t l = 0;
+            while(text[a + l] == text[b + l]) ++l;
+            return l;
+        };
+
+        // the lexicographically smallest suffix inserted so far
+        size_t head = undef;
+
+        // the position at which the next phrase starts
+        size_t next = 0;
+
+        for(size_t i = 0; i < n; ++i) {
+            // insert suffix i after its PSV
+            const size_t psv_pos = psv[i];
+            size_t nsv_pos;
+            if(psv_pos == undef) {
+                nsv_pos = head;
+                head = i;
+            } else {
+                nsv_pos = psv[psv_pos];
+                psv[psv_pos] = i;
+            }
+            psv[i] = nsv_pos;
+
+            if(i < next) continue;
+
+            const size_t psv_lcp = (psv_pos != undef) ? lcp(psv_pos, i) : 0;
+            const size_t nsv_lcp = (nsv_pos != undef) ? lcp(nsv_pos, i) : 0;
+
+            //select maximum
+            const size_t max_lcp = std::max(psv_lcp, nsv_lcp);
+            if(max_lcp >= threshold) {
+                const size_t max_pos = max_lcp == psv_lcp ? psv_pos : nsv_pos;
+                DCHECK_LT(max_pos, i);
+                // new factor
+                factors.emplace_back(i, max_pos, max_lcp);
+
+                next = i + max_lcp; //advance
+            } else {
+                next = i + 1; //advance
+            }
+        }
+    }
+
 public:
     inline static Meta meta() {
         Meta m("compressor", "lzss_lcp", "LZSS Factorization using LCP");
         m.option("coder").templated<coder_t>("coder");
         m.option("textds").templated<text_t, TextDS<>>("textds");
         m.option("threshold").dynamic(3);
+        m.option("strategy").dynamic("psv_nsv");
+        m.option("threads").dynamic(1);
         m.uses_textds<text_t>(text_t::SA | text_t::ISA | text_t::LCP);
         return m;
     }
@@ -43,71 +364,35 @@ public:
         auto view = input.as_view();
         DCHECK(view.ends_with(uint8_t(0)));
 
+        const std::string strategy = env().option("strategy").as_string();
+        const bool naive = (strategy == "naive");
+        const bool lean = (strategy == "lean");
+        CHECK(naive || lean || strategy == "psv_nsv")
+            << "unknown factorization strategy: " << strategy;
+
         // Construct text data structures
+        ds::dsflags_t ds_flags = 0;
+        if(!lean) ds_flags |= text_t::SA;
+        if(naive) ds_flags |= text_t::ISA | text_t::LCP;
+
         text_t text = StatPhase::wrap("Construct Text DS", [&]{
-            return text_t(env().env_for_option("textds"), view,
-                    text_t::SA | text_t::ISA | text_t::LCP);
+            return text_t(env().env_for_option("textds"), view, ds_flags);
         });
 
-        auto& sa = text.require_sa();
-        auto& isa = text.require_isa();
-        auto& lcp = text.require_lcp();
-
         // Factorize
-        const len_t text_length = text.size();
         lzss::FactorBuffer factors;
 
         StatPhase::wrap("Factorize", [&]{
             const len_t threshold = env().option("threshold").as_integer(); //factor threshold
+            size_t threads = env().option("threads").as_integer();
+            if(threads == 0) threads = hardware_threads();
 
-            for(len_t i = 0; i+1 < text_length;) { // we omit T[text_length-1] since we assume that it is the \0 byte!
-                //get SA position for suffix i
-                const size_t& cur_pos = isa[i];
-			    DCHECK_NE(cur_pos,0); // isa[i] == 0 <=> T[i] = 0
-
-			    //compute naively PSV
-                //search "upwards" in LCP array
-                //include current, exclude last
-                size_t psv_lcp = lcp[cur_pos];
-                ssize_t psv_pos = cur_pos - 1;
-                if (psv_lcp > 0) {
-                    while (psv_pos >= 0 && sa[psv_pos] > sa[cur_pos]) {
-                        psv_lcp = std::min<size_t>(psv_lcp, lcp[psv_pos--]);
-                    }
-                }
-
-			    //compute naively NSV, TODO: use NSV data structure
-                //search "downwards" in LCP array
-                //exclude current, include last
-                size_t nsv_lcp = 0;
-                size_t nsv_pos = cur_pos + 1;
-                if (nsv_pos < text_length) {
-                    nsv_lcp = SSIZE_MAX;
-                    do {
-                        nsv_lcp = std::min<size_t>(nsv_lcp, lcp[nsv_pos]);
-                        if (sa[nsv_pos] < sa[cur_pos]) {
-                            break;
-                        }
-                    } while (++nsv_pos < text_length);
-
-                    if (nsv_pos >= text_length) {
-                        nsv_lcp = 0;
-                    }
-                }
-
-                //select maximum
-                const size_t& max_lcp = std::max(psv_lcp, nsv_lcp);
-                if(max_lcp >= threshold) {
-				    const ssize_t& max_pos = max_lcp == psv_lcp ? psv_pos : nsv_pos;
-				    DCHECK_LT(max_pos, text_length);
-				    DCHECK_GE(max_pos, 0);
-                    // new factor
-                    factors.emplace_back(i, sa[max_pos], max_lcp);
-
-                    i += max_lcp; //advance
-                } else {
-                    ++i; //advance
-                }
+            if(naive) {
+                factorize_naive(text, threshold, factors);
+            } else if(lean) {
+                factorize_lean(text, threshold, factors);
+            } else {
+                factorize_psv_nsv(text, threshold, threads, factors);
             }
 
             StatPhase::log("threshold", threshold);
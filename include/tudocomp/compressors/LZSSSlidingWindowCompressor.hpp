@@ -1,5 +1,9 @@
 #pragma once
 
+#include <algorithm>
+#include <limits>
+#include <vector>
+
 #include <tudocomp/Compressor.hpp>
 #include <tudocomp/Literal.hpp>
 #include <tudocomp/Range.hpp>
@@ -11,18 +15,151 @@ namespace tdc {
 
 /// Computes the LZ77 factorization of the input by moving a sliding window
 /// over it in which redundant phrases will be looked for.
+///
+/// Phrases are found using hash chains over the first three characters of
+/// each position in the window, as known from deflate. The amount of
+/// candidates checked per position is limited by the `chain` option. With
+/// `lazy` matching, a phrase is only taken if the next position does not
+/// start a longer one.
+///
+/// The input is read in blocks into a buffer that holds the window and the
+/// look-ahead, so arbitrarily long streams are processed in memory linear
+/// in the window size.
 template<typename coder_t>
 class LZSSSlidingWindowCompressor : public Compressor {
 
 private:
+    /// The amount of characters hashed to find phrase candidates.
+    static constexpr size_t MIN_MATCH = 3;
+
+    static constexpr size_t NONE = std::numeric_limits<size_t>::max();
+
     size_t m_window;
 
+    /// The match finder, working on absolute text positions.
+    class MatchFinder {
+        std::istream& m_ins;
+        const size_t m_window;
+        const size_t m_chain;
+
+        std::vector<uint8_t> m_buf; // text from m_buf_off on
+        size_t m_buf_off = 0;
+        size_t m_capacity;
+        bool m_eof = false;
+
+        size_t m_hash_bits;
+        std::vector<size_t> m_head; // latest position per hash value
+        std::vector<size_t> m_prev; // previous position with the same hash
+        size_t m_prev_mask;
+
+        inline size_t hash(size_t pos) const {
+            const uint8_t* p = &m_buf[pos - m_buf_off];
+            const uint32_t x = (uint32_t(p[0]) << 16) |
+                               (uint32_t(p[1]) << 8) |
+                                uint32_t(p[2]);
+            return (x * 2654435761u) >> (32 - m_hash_bits);
+        }
+
+    public:
+        inline MatchFinder(std::istream& ins, size_t window, size_t chain)
+            : m_ins(ins), m_window(window), m_chain(chain) {
+
+            // window, look-ahead and one window of progress between refills
+            m_capacity = 2 * m_window + m_window + 1;
+            m_buf.reserve(m_capacity);
+
+            m_hash_bits = std::max(size_t(8), std::min(size_t(20),
+                                                       size_t(bits_for(m_window))));
+            m_head.assign(size_t(1) << m_hash_bits, size_t(NONE));
+
+            const size_t prev_size = size_t(1) << bits_for(m_window);
+            m_prev.assign(prev_size, size_t(NONE));
+            m_prev_mask = prev_size - 1;
+        }
+
+        /// Makes sure the look-ahead of `pos` is buffered,
+        /// discarding the text before its window.
+        inline void fill(size_t pos) {
+            if(m_eof || pos + m_window + 1 <= end()) return;
+
+            const size_t keep = (pos > m_window) ? pos - m_window : 0;
+            if(keep > m_buf_off) {
+                m_buf.erase(m_buf.begin(), m_buf.begin() + (keep - m_buf_off));
+                m_buf_off = keep;
+            }
+
+            const size_t old_size = m_buf.size();
+            m_buf.resize(m_capacity);
+            m_ins.read((char*) m_buf.data() + old_size, m_capacity - old_size);
+            const size_t read = m_ins.gcount();
+            m_buf.resize(old_size + read);
+
+            if(old_size + read < m_capacity) m_eof = true;
+        }
+
+        /// The position after the last buffered character.
+        inline size_t end() const {
+            return m_buf_off + m_buf.size();
+        }
+
+        inline uint8_t operator[](size_t pos) const {
+            return m_buf[pos - m_buf_off];
+        }
+
+        /// Registers `pos` as a phrase candidate for later positions.
+        inline void insert(size_t pos) {
+            if(pos + MIN_MATCH > end()) return;
+
+            const size_t h = hash(pos);
+            m_prev[pos & m_prev_mask] = m_head[h];
+            m_head[h] = pos;
+        }
+
+        /// Finds the longest phrase starting at `pos` in the window.
+        ///
+        /// Returns its length and stores its source in `src`.
+        inline size_t find(size_t pos, size_t& src) const {
+            const size_t max_len = std::min(m_window, end() - pos);
+            if(max_len < MIN_MATCH) return 0;
+
+            const size_t limit = (pos > m_window) ? pos - m_window : 0;
+            const uint8_t* cur = &m_buf[pos - m_buf_off];
+
+            size_t best = 0;
+            size_t chain = m_chain;
+            size_t q = m_head[hash(pos)];
+
+            while(q < pos && q >= limit && chain--) {
+                const uint8_t* cand = &m_buf[q - m_buf_off];
+
+                if(cand[best] == cur[best]) {
+                    size_t j = 0;
+                    while(j < max_len && cand[j] == cur[j]) ++j;
+
+                    if(j > best) {
+                        best = j;
+                        src = q;
+                        if(best == max_len) break;
+                    }
+                }
+
+                // stop at stale entries of the chain
+                const size_t next = m_prev[q & m_prev_mask];
+                if(next >= q) break;
+                q = next;
+            }
+            return best;
+        }
+    };
+
 public:
     inline static Meta meta() {
         Meta m("compressor", "lzss", "Lempel-Ziv-Storer-Szymanski (Sliding Window)");
         m.option("coder").templated<coder_t>("coder");
-        m.option("window").dynamic(16);
+        m.option("window").dynamic(65536);
         m.option("threshold").dynamic(3);
+        m.option("chain").dynamic(64);
+        m.option("lazy").dynamic(true);
         return m;
     }
 
@@ -33,6 +170,7 @@ public:
     inline LZSSSlidingWindowCompressor(Env&& e) : Compressor(std::move(e))
     {
         m_window = this->env().option("window").as_integer();
+        CHECK_GT(m_window, 0u) << "the window must not be empty";
     }
 
     /// \copydoc Compressor::compress
@@ -41,107 +179,113 @@ public:
 
         typename coder_t::Encoder coder(env().env_for_option("coder"), output, NoLiterals());
 
-        std::vector<uint8_t> buf;
-
-        size_t ahead = 0; //marks the index in the buffer at which the back buffer ends and the ahead buffer begins
-        char c;
-
         StatPhase phase("Factorize");
 
-        //initially fill the buffer
-        size_t buf_off = 0;
-        while(buf.size() < 2 * m_window && ins.get(c)) {
-            buf.push_back(uint8_t(c));
-        }
+        const size_t threshold = std::max(size_t(1), //factor threshold
+            size_t(env().option("threshold").as_integer()));
+        const size_t chain = env().option("chain").as_integer();
+        const bool lazy = env().option("lazy").as_bool();
 
-        //factorize
-        const len_t threshold = env().option("threshold").as_integer(); //factor threshold
         phase.log_stat("threshold", threshold);
+        phase.log_stat("window", m_window);
+        phase.log_stat("chain", chain);
 
-        size_t pos = 0;
-        bool eof = false;
-        while(ahead < buf.size()) {
-            size_t fpos = 0, fsrc = 0, fnum = 0;
-
-            //walk back buffer
-            for(size_t k = (ahead > m_window ? ahead - m_window : 0); k < ahead; k++) {
-                //compare string
-                size_t j = 0;
-                while(ahead + j < buf.size() && buf[k + j] == buf[ahead + j]) {
-                    ++j;
-                }
+        MatchFinder mf(ins, m_window, chain);
 
-                //factorize if longer than one already found
-                if(j >= threshold && j > fnum) {
-                    fpos = buf_off + ahead;
-                    fsrc = buf_off + k;
-                    fnum = j;
-                }
-            }
+        auto encode_factor = [&](size_t pos, size_t src, size_t len) {
+            coder.encode(true, bit_r);
+            coder.encode(pos - src, Range(std::min(pos, m_window))); //delta
+            coder.encode(len, Range(m_window));
+        };
 
-            //output longest factor or symbol
-            size_t advance;
+        auto encode_literal = [&](size_t pos) {
+            coder.encode(false, bit_r);
+            coder.encode(uliteral_t(mf[pos]), literal_r);
+        };
 
-            if(fnum > 0) {
-                // encode factor
-                coder.encode(true, bit_r);
-                coder.encode(fpos - fsrc, Range(fpos)); //delta
-                coder.encode(fnum, Range(m_window));
+        //factorize
+        size_t num_factors = 0;
+        size_t pos = 0;
+        size_t next_len = 0, next_src = 0;
+        bool has_next = false;
 
-                advance = fnum;
+        mf.fill(pos);
+        while(pos < mf.end()) {
+            size_t len, src = 0;
+            if(has_next) {
+                // already looked up by lazy matching
+                len = next_len;
+                src = next_src;
+                has_next = false;
             } else {
-                // encode literal
-                coder.encode(false, bit_r);
-                coder.encode(uliteral_t(buf[ahead]), literal_r);
-
-                advance = 1;
+                len = mf.find(pos, src);
             }
+            mf.insert(pos);
 
-            //advance buffer
-            pos += advance;
-            while(advance--) {
-                if(ahead < m_window) {
-                    //case 1: still reading the first w symbols from the stream
-                    ++ahead;
-                } else if(!eof && ins.get(c)) {
-                    //case 2: read a new symbol
-                    buf.erase(buf.begin()); //TODO ouch
-                    buf.push_back(uint8_t(c));
-                    ++buf_off;
-                } else {
-                    //case 3: EOF, read rest of buffer
-                    eof = true;
-                    ++ahead;
+            if(len >= threshold && lazy && pos + len < mf.end()) {
+                next_len = mf.find(pos + 1, next_src);
+                if(next_len > len) {
+                    // defer to the longer phrase
+                    encode_literal(pos);
+                    has_next = true;
+                    mf.fill(++pos);
+                    continue;
                 }
             }
+
+            if(len >= threshold) {
+                encode_factor(pos, src, len);
+                ++num_factors;
+
+                for(size_t i = 1; i < len; i++) mf.insert(pos + i);
+                pos += len;
+            } else {
+                encode_literal(pos);
+                ++pos;
+            }
+            mf.fill(pos);
         }
+
+        phase.log_stat("factors", num_factors);
     }
 
     inline virtual void decompress(Input& input, Output& output) override {
         typename coder_t::Decoder decoder(env().env_for_option("coder"), input);
+        auto outs = output.as_stream();
+
+        // only the window needs to be kept, older text is written out
+        std::vector<uliteral_t> buf;
+        buf.reserve(3 * m_window);
+        size_t buf_off = 0;
 
-        std::vector<uliteral_t> text;
         while(!decoder.eof()) {
+            const size_t pos = buf_off + buf.size();
+
             bool is_factor = decoder.template decode<bool>(bit_r);
             if(is_factor) {
-                size_t fsrc = text.size() - decoder.template decode<size_t>(Range(text.size()));
-
-                //TODO are the compressor options saved into tudocomp's magic?
-                size_t fnum = decoder.template decode<size_t>(Range(m_window));
+                const size_t delta = decoder.template decode<size_t>(
+                    Range(std::min(pos, m_window)));
+                const size_t fnum = decoder.template decode<size_t>(Range(m_window));
 
+                size_t fsrc = pos - delta - buf_off;
                 for(size_t i = 0; i < fnum; i++) {
-                    text.push_back(text[fsrc+i]);
+                    buf.push_back(buf[fsrc+i]);
                 }
             } else {
                 auto c = decoder.template decode<uliteral_t>(literal_r);
-                text.push_back(c);
+                buf.push_back(c);
+            }
+
+            if(buf.size() >= 3 * m_window) {
+                const size_t flush = buf.size() - m_window;
+                outs.write((const char*) buf.data(), flush);
+                buf.erase(buf.begin(), buf.begin() + flush);
+                buf_off += flush;
             }
         }
 
-        auto outs = output.as_stream();
-        for(uint8_t c : text) outs << c;
+        outs.write((const char*) buf.data(), buf.size());
     }
 };
 
 } //ns
-
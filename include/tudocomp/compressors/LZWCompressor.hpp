@@ -37,8 +37,10 @@ public:
     }
 
     virtual void compress(Input& input, Output& out) override {
-        const size_t n = input.size();
-        const size_t reserved_size = isqrt(n)*2;
+        // the size is only a hint, unknown for inputs read from a pipe
+        const size_t size_hint = input.size_hint();
+        const size_t n = (size_hint == Input::npos) ? lz78::UNKNOWN_TEXT_SIZE : size_hint;
+        const size_t reserved_size = (size_hint == Input::npos) ? 0 : isqrt(n)*2;
         auto is = input.as_stream();
 
         // Stats
@@ -108,16 +110,20 @@ public:
     }
 
     virtual void decompress(Input& input, Output& output) override final {
-        const size_t reserved_size = input.size();
+        const size_t size_hint = input.size_hint();
+        const size_t reserved_size = (size_hint == Input::npos) ? 0 : size_hint;
         //TODO C::decode(in, out, dms, reserved_size);
         auto out = output.as_stream();
         typename coder_t::Decoder decoder(env().env_for_option("coder"), input);
 
+        const lz78::factorid_t dms = m_dict_max_size == 0 ? lz78::DMS_MAX : m_dict_max_size;
         size_t counter = 0;
 
         //TODO file_corrupted not used!
-        lzw::decode_step([&](lz78::factorid_t& entry, bool reset, bool &file_corrupted) -> bool {
-            if (reset) {
+        lzw::decode_step([&](lz78::factorid_t& entry, bool, bool &file_corrupted) -> bool {
+            // the encoder resets its dictionary after encoding as many codes
+            // as fit into it, one code before the decoder's dictionary is full
+            if (counter + ULITERAL_MAX + 1 == dms) {
                 counter = 0;
             }
 
@@ -129,7 +135,7 @@ public:
             counter++;
             entry = factor;
             return true;
-        }, out, m_dict_max_size == 0 ? lz78::DMS_MAX : m_dict_max_size, reserved_size);
+        }, out, dms, reserved_size);
     }
 
 };
@@ -3,9 +3,15 @@
 #include <tudocomp/util.hpp>
 #include <tudocomp/Compressor.hpp>
 #include <tudocomp/Env.hpp>
+#include <cstring>
 #include <numeric>
+#include <vector>
 #include <tudocomp/def.hpp>
 
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 namespace tdc {
 
 
@@ -42,30 +48,91 @@ value_type mtf_decode_char(const value_type v, value_type*const table) {
 	return return_value;
 }
 
+/**
+ * Returns the position of 'v' in a Move-To-Front table of all 256 byte
+ * values, comparing 32 (AVX2) or 16 (SSE2) entries at once
+ */
+inline size_t mtf_find(const uliteral_t*const table, const uliteral_t v) {
+#if defined(__AVX2__)
+	const __m256i needle = _mm256_set1_epi8(static_cast<char>(v));
+	for(size_t i = 0; i < 256; i += 32) {
+		const __m256i entries = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(table + i));
+		const uint32_t mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(entries, needle));
+		if(mask != 0) return i + __builtin_ctz(mask);
+	}
+#elif defined(__SSE2__)
+	const __m128i needle = _mm_set1_epi8(static_cast<char>(v));
+	for(size_t i = 0; i < 256; i += 16) {
+		const __m128i entries = _mm_loadu_si128(reinterpret_cast<const __m128i*>(table + i));
+		const uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(entries, needle));
+		if(mask != 0) return i + __builtin_ctz(mask);
+	}
+#else
+	for(size_t i = 0; i < 256; ++i) {
+		if(table[i] == v) return i;
+	}
+#endif
+	DCHECK(false) << "table is not a permutation";
+	return 0;
+}
+
+/**
+ * Encodes the bytes of 'block' in place by Move-To-Front Coding
+ * Needs and modifies a lookup table of all 256 byte values
+ */
+inline void mtf_encode_block(uliteral_t*const block, const size_t size, uliteral_t*const table) {
+	for(size_t k = 0; k < size; ++k) {
+		const uliteral_t v = block[k];
+		const size_t i = mtf_find(table, v);
+		std::memmove(table + 1, table, i);
+		table[0] = v;
+		block[k] = i;
+	}
+}
+
+/**
+ * Decodes the bytes of 'block' in place by Move-To-Front Coding
+ * Needs and modifies a lookup table of all 256 byte values
+ */
+inline void mtf_decode_block(uliteral_t*const block, const size_t size, uliteral_t*const table) {
+	for(size_t k = 0; k < size; ++k) {
+		const size_t i = block[k];
+		const uliteral_t v = table[i];
+		std::memmove(table + 1, table, i);
+		table[0] = v;
+		block[k] = v;
+	}
+}
+
+/**
+ * Applies 'f' to consecutive blocks of the stream 'is' in place and
+ * writes them to 'os'
+ */
+template<class char_type, class F>
+void mtf_blockwise(std::basic_istream<char_type>& is, std::basic_ostream<char_type>& os, F f) {
+	static_assert(sizeof(char_type) == sizeof(uliteral_t), "MTF works on bytes");
+	static constexpr size_t block_size = 1ULL << 16;
+	std::vector<char_type> block(block_size);
+	uliteral_t table[256];
+	std::iota(table, table+256, 0);
+
+	while(is) {
+		is.read(block.data(), block_size);
+		const size_t size = is.gcount();
+		if(size == 0) break;
+		f(reinterpret_cast<uliteral_t*>(block.data()), size, table);
+		os.write(block.data(), size);
+	}
+}
+
 template<class char_type = uliteral_t>
 void mtf_encode(std::basic_istream<char_type>& is, std::basic_ostream<char_type>& os) {
-	typedef typename std::make_unsigned<char_type>::type value_type; // -> default: uint8_t
-	static constexpr size_t table_size = std::numeric_limits<value_type>::max()+1;
-	value_type table[table_size];
-	std::iota(table, table+table_size, 0);
-
-	char_type c;
-	while(is.get(c)) {
-		os << mtf_encode_char(static_cast<value_type>(c), table, table_size);
-	}
+	mtf_blockwise(is, os, mtf_encode_block);
 }
 
 template<class char_type = uliteral_t>
 void mtf_decode(std::basic_istream<char_type>& is, std::basic_ostream<char_type>& os) {
-	typedef typename std::make_unsigned<char_type>::type value_type; // -> default: uint8_t
-	static constexpr size_t table_size = std::numeric_limits<value_type>::max()+1;
-	value_type table[table_size];
-	std::iota(table, table+table_size, 0);
-
-	char_type c;
-	while(is.get(c)) {
-		os << mtf_decode_char(static_cast<value_type>(c), table);
-	}
+	mtf_blockwise(is, os, mtf_decode_block);
 }
 
 class MTFCompressor : public Compressor {
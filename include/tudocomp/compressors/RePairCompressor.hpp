@@ -5,31 +5,41 @@
 #include <tudocomp/Range.hpp>
 #include <tudocomp/coders/BitCoder.hpp> //default
 
-#include <tudocomp/util/Counter.hpp>
+#include <tudocomp/compressors/repair/RePairGrammar.hpp>
 
 #include <tudocomp_stat/StatPhase.hpp>
 
 namespace tdc {
 
+/// Computes a RePair grammar of the input, see \ref repair::Grammar.
+///
+/// With the `lean` option, the text and the occurrence lists are stored
+/// bit-packed. Otherwise, they take 32-bit symbols and links of type
+/// `len_compact_t`, which limits the text length to somewhat less than
+/// 4 GiB. The digram records are stored the same way in both modes.
+///
+/// Substrings can be extracted without deriving the text before them,
+/// see \ref repair::extract.
 template <typename coder_t>
 class RePairCompressor : public Compressor {
 private:
-    typedef uint32_t sym_t;
-    typedef uint64_t digram_t;
-    typedef std::vector<digram_t> grammar_t;
-    static const size_t digram_shift = 32UL;
-    static const sym_t sigma = 256; //TODO
+    using sym_t = repair::sym_t;
+    using digram_t = repair::digram_t;
+    using grammar_t = repair::grammar_t;
+
+    /// Symbols below sigma are the input bytes, the others are rules.
+    static const sym_t sigma = 256;
 
     inline static digram_t digram(sym_t l, sym_t r) {
-        return (digram_t(l) << digram_shift) | digram_t(r);
+        return repair::digram(l, r);
     }
 
     inline static sym_t left(digram_t di) {
-        return sym_t(di >> digram_shift);
+        return repair::left(di);
     }
 
     inline static sym_t right(digram_t di) {
-        return sym_t(di);
+        return repair::right(di);
     }
 
     template<typename text_t>
@@ -37,18 +47,20 @@ private:
     private:
         const text_t* m_text;
         len_t         m_text_size;
-        const len_compact_t*  m_next;
         len_t         m_pos;
 
         std::vector<uliteral_t> m_g_literals;
         len_t                   m_g_pos;
 
+        inline void skip_nonterminals() {
+            while(m_pos < m_text_size && (*m_text)[m_pos] >= sigma) ++m_pos;
+        }
+
     public:
         inline Literals(const text_t& text,
                         len_t text_size,
-                        const len_compact_t* next,
                         const grammar_t& grammar)
-            : m_text(&text), m_text_size(text_size), m_next(next),
+            : m_text(&text), m_text_size(text_size),
               m_pos(0), m_g_pos(0) {
 
             // count literals from right side of grammar rules
@@ -59,6 +71,8 @@ private:
                 sym_t r = right(di);
                 if(r < sigma) m_g_literals.push_back(uliteral_t(r));
             }
+
+            skip_nonterminals();
         }
 
         inline bool has_next() const {
@@ -69,9 +83,10 @@ private:
             assert(has_next());
 
             if(m_pos < m_text_size) {
-                // from encoded text
+                // from encoded text, skipping non-terminals
                 auto l = Literal { uliteral_t((*m_text)[m_pos]), m_pos };
-                m_pos = m_next[m_pos];
+                ++m_pos;
+                skip_nonterminals();
                 return l;
             } else {
                 // from grammar right sides
@@ -88,6 +103,7 @@ public:
         Meta m("compressor", "repair", "Re-Pair compression");
         m.option("coder").templated<coder_t, BitCoder>("coder");
         m.option("max_rules").dynamic(0);
+        m.option("lean").dynamic(false);
         return m;
     }
 
@@ -98,115 +114,34 @@ public:
         size_t max_rules = env().option("max_rules").as_integer();
         if(max_rules == 0) max_rules = SIZE_MAX;
 
-        // prepare editable text
-        len_t n;
-        sym_t *text;
-        len_compact_t *next; //TODO use an int vector of required bit width
-
-        {
-            auto view = input.as_view();
-            n = view.size();
-            text = new sym_t[n];
-            next = new len_compact_t[n];
-
-            for(size_t i = 0; i < n; i++) {
-                text[i] = view[i];
-                next[i] = i + 1;
-            }
-        }
-
         // compute RePair grammar
         grammar_t grammar;
+        std::vector<sym_t> text;
+        size_t num_replaced;
 
-        size_t num_replaced = 0;
-
-        do {
-            // count digrams
-            digram_t max;
-            size_t max_count = 0;
-
-            {
-                std::unordered_map<digram_t, size_t> count;
-                // TODO: probably not optimal, but twice as fast as std::map
-
-                size_t i = 0;
-                while(i < n - 1) {
-                    size_t j = next[i];
-                    if(j >= n) break; // break if at end
-
-                    digram_t di = digram(text[i], text[j]);
-
-                    // update counter
-                    size_t c = count[di] + 1;
-                    count[di] = c;
-
-                    // update max
-                    if(c > max_count) {
-                        max = di;
-                        max_count = c;
-                    }
-
-                    // advance
-                    i = j;
-                }
-            }
-
-            // replace most common digram (max)
-            if(max_count > 1) {
-                sym_t new_sym = sigma + grammar.size();
-                grammar.push_back(max);
-
-                size_t i = 0;
-                while(i < n - 1) {
-                    size_t j = next[i];
-                    if(j >= n) break; // break if at end
-
-                    digram_t di = digram(text[i], text[j]);
-                    if(di == max) {
-                        text[i] = new_sym; // replace symbol at i by new symbol
-                        next[i] = next[j];
-
-                        ++num_replaced;
-                    }
-
-                    // advance
-                    i = next[i];
-                }
-            } else {
-                break; // done
-            }
-        } while(grammar.size() < max_rules);
+        auto compute = [&](auto&& g) {
+            grammar = g.grammar();
+            text = g.sequence();
+            num_replaced = g.replaced();
+        };
 
-        // debug
-        /*
         {
-            DLOG(INFO) << "grammar:";
-            for(size_t i = 0; i < grammar.size(); i++) {
-                digram_t di = grammar[i];
-                sym_t l = left(di);
-                sym_t r = right(di);
-
-                DLOG(INFO) << uint8_t('A' + i) << " -> " <<
-                    uint8_t((l < sigma) ? l : ('A' + l - sigma)) <<
-                    uint8_t((r < sigma) ? r : ('A' + r - sigma));
-            }
-
-            std::ostringstream start;
-            for(size_t i = 0; i < n; i = next[i]) {
-                sym_t x = text[i];
-                start << uint8_t((x < sigma) ? x : ('A' + x - sigma));
+            auto view = input.as_view();
+            if(env().option("lean").as_bool()) {
+                compute(repair::Grammar<DynamicIntVector, DynamicIntVector>(
+                    view, view.size(), sigma, max_rules));
+            } else {
+                compute(repair::Grammar<std::vector<sym_t>, std::vector<len_compact_t>>(
+                    view, view.size(), sigma, max_rules));
             }
-
-            DLOG(INFO) << "S -> " << start.str();
         }
-        */
 
         StatPhase::log("rules", grammar.size());
         StatPhase::log("replaced", num_replaced);
 
         // instantiate encoder
         typename coder_t::Encoder coder(env().env_for_option("coder"),
-            output, Literals<sym_t*>(text, n, next, grammar));
+            output, Literals<std::vector<sym_t>>(text, text.size(), grammar));
 
         // encode amount of grammar rules
         coder.encode(grammar.size(), len_r);
@@ -252,22 +187,16 @@ public:
         size_t num_text_nonterminals = 0;
 
         Range grammar_r(grammar.size());
-        for(size_t i = 0; i < n; i = next[i]) {
-            sym_t x = text[i];
-
+        for(sym_t x : text) {
             // statistics
             if(x < sigma) ++num_text_terminals;
             else ++num_text_nonterminals;
 
-            encode_sym(text[i], grammar_r);
+            encode_sym(x, grammar_r);
         }
 
         StatPhase::log("text_terms", num_text_terminals);
         StatPhase::log("text_nonterms", num_text_nonterminals);
-
-        // clean up
-        delete[] next;
-        delete[] text;
     }
 
 private:
@@ -283,34 +212,38 @@ private:
         }
     }
 
+    template<typename decoder_t>
+    inline static sym_t decode_sym(decoder_t& decoder, const Range& r) {
+        bool is_nonterminal = decoder.template decode<bool>(bit_r);
+        if(is_nonterminal) {
+            auto dec = decoder.template decode<sym_t>(r);
+            return sigma + dec;
+        } else {
+            auto dec = sym_t(decoder.template decode<uliteral_t>(literal_r));
+            return dec;
+        }
+    }
+
+    template<typename decoder_t>
+    inline static grammar_t decode_grammar(decoder_t& decoder) {
+        grammar_t grammar;
+        auto num_rules = decoder.template decode<size_t>(len_r);
+        while(num_rules--) {
+            Range grammar_r(grammar.size());
+            sym_t l = decode_sym(decoder, grammar_r);
+            sym_t r = decode_sym(decoder, grammar_r);
+            grammar.push_back(digram(l, r));
+        }
+        return grammar;
+    }
+
 public:
     virtual void decompress(Input& input, Output& output) override {
         // instantiate decoder
         typename coder_t::Decoder decoder(env().env_for_option("coder"), input);
 
-        // lambda for decoding symbols
-        auto decode_sym = [&](const Range& r) {
-            bool is_nonterminal = decoder.template decode<bool>(bit_r);
-            if(is_nonterminal) {
-                auto dec = decoder.template decode<sym_t>(r);
-                return sigma + dec;
-            } else {
-                auto dec = sym_t(decoder.template decode<uliteral_t>(literal_r));
-                return dec;
-            }
-        };
-
         // decode grammar
-        grammar_t grammar;
-        {
-            auto num_rules = decoder.template decode<size_t>(len_r);
-            while(num_rules--) {
-                Range grammar_r(grammar.size());
-                sym_t l = decode_sym(grammar_r);
-                sym_t r = decode_sym(grammar_r);
-                grammar.push_back(digram(l, r));
-            }
-        }
+        grammar_t grammar = decode_grammar(decoder);
 
         // debug
         /*{
@@ -331,7 +264,41 @@ public:
 
         auto ostream = output.as_stream();
         while(!decoder.eof()) {
-            decode(decode_sym(grammar_r), grammar, ostream);
+            decode(decode_sym(decoder, grammar_r), grammar, ostream);
+        }
+    }
+
+    /// Decodes the grammar and the start rule up to the requested part of
+    /// the text, which is then derived using the expansion lengths of the
+    /// rules. The remainder of the start rule is not decoded.
+    ///
+    /// The whole grammar is decoded and the start rule is scanned from its
+    /// beginning, so this takes time linear in the size of the grammar plus
+    /// the amount of start rule symbols up to the end of the requested part,
+    /// plus the height of the grammar and `len`. Only the time for deriving
+    /// the text before `from` is saved.
+    virtual void extract(Input& input, Output& output,
+                         size_t from, size_t len) override {
+        typename coder_t::Decoder decoder(env().env_for_option("coder"), input);
+
+        grammar_t grammar = decode_grammar(decoder);
+        auto lengths = repair::expansion_lengths(grammar, sigma);
+
+        Range grammar_r(grammar.size());
+
+        auto ostream = output.as_stream();
+        size_t pos = 0;
+        while(len > 0 && !decoder.eof()) {
+            sym_t x = decode_sym(decoder, grammar_r);
+            const size_t x_len = (x < sigma) ? 1 : lengths[x - sigma];
+
+            if(from < pos + x_len) {
+                const size_t offset = (from > pos) ? from - pos : 0;
+                const size_t n = std::min(len, x_len - offset);
+                repair::extract(ostream, grammar, lengths, sigma, x, offset, n);
+                len -= n;
+            }
+            pos += x_len;
         }
     }
 };
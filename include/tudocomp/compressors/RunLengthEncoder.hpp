@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstring>
+#include <vector>
 #include <tudocomp/util.hpp>
 #include <tudocomp/util/vbyte.hpp>
 #include <tudocomp/Env.hpp>
@@ -7,46 +9,223 @@
 
 namespace tdc {
 
+/// \brief Contains helpers for the block-wise run length encoding.
+namespace rle {
+	/// The amount of bytes read and written at once.
+	static constexpr size_t BLOCK_SIZE = 1ULL << 16;
+
+	inline uint64_t load_word(const uliteral_t* p) {
+		uint64_t w;
+		std::memcpy(&w, p, sizeof(w));
+		return w;
+	}
+
+	/// Returns the index of the first non-zero byte of a non-zero word
+	/// loaded with \ref load_word.
+	inline size_t first_nonzero_byte(uint64_t w) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+		return __builtin_ctzll(w) / 8;
+#else
+		return __builtin_clzll(w) / 8;
+#endif
+	}
+
+	/// Returns the index of the first zero byte of a word, or 8 if there is none.
+	inline size_t first_zero_byte(uint64_t w) {
+		static constexpr uint64_t LOW = 0x7F7F7F7F7F7F7F7FULL;
+		// the highest bit of each byte is set iff the byte is zero
+		const uint64_t zero = ~(((w & LOW) + LOW) | w | LOW);
+		return zero ? first_nonzero_byte(zero) : 8;
+	}
+
+	/// Returns the first position in `[i, n)` whose byte differs from `c`,
+	/// or `n` if there is none.
+	inline size_t run_end(const uliteral_t* data, size_t i, const size_t n, const uliteral_t c) {
+		const uint64_t pattern = 0x0101010101010101ULL * c;
+		for(; i + 8 <= n; i += 8) {
+			const uint64_t diff = load_word(data + i) ^ pattern;
+			if(diff != 0) return i + first_nonzero_byte(diff);
+		}
+		while(i < n && data[i] == c) ++i;
+		return i;
+	}
+
+	/// Returns the first position `k` in `[i, n)` whose byte equals its
+	/// predecessor, which is `prev` for position `i`, or `n` if there is none.
+	inline size_t next_pair(const uliteral_t* data, size_t i, const size_t n, const uliteral_t prev) {
+		if(i == n || data[i] == prev) return i;
+		for(++i; i + 8 <= n; i += 8) {
+			const size_t k = first_zero_byte(load_word(data + i) ^ load_word(data + i - 1));
+			if(k < 8) return i + k;
+		}
+		while(i < n && data[i] != data[i-1]) ++i;
+		return i;
+	}
+
+	/// \brief Collects bytes to write them to a stream in blocks.
+	template<class char_type>
+	class OutputBuffer {
+		std::basic_ostream<char_type>& m_os;
+		std::vector<uliteral_t> m_buffer;
+		size_t m_size = 0;
+
+	public:
+		inline OutputBuffer(std::basic_ostream<char_type>& os): m_os(os), m_buffer(BLOCK_SIZE) {}
+
+		inline void flush() {
+			m_os.write(reinterpret_cast<const char_type*>(m_buffer.data()), m_size);
+			m_size = 0;
+		}
+
+		inline void put(const uliteral_t c) {
+			if(m_size == m_buffer.size()) flush();
+			m_buffer[m_size++] = c;
+		}
+
+		inline void write(const uliteral_t* data, const size_t len) {
+			if(m_size + len > m_buffer.size()) {
+				flush();
+				if(len > m_buffer.size()) {
+					m_os.write(reinterpret_cast<const char_type*>(data), len);
+					return;
+				}
+			}
+			std::memcpy(m_buffer.data() + m_size, data, len);
+			m_size += len;
+		}
+
+		/// Writes `len` copies of `c`.
+		inline void fill(const uliteral_t c, size_t len) {
+			while(len > 0) {
+				if(m_size == m_buffer.size()) flush();
+				const size_t n = std::min(len, m_buffer.size() - m_size);
+				std::memset(m_buffer.data() + m_size, c, n);
+				m_size += n;
+				len -= n;
+			}
+		}
+
+		inline void put_vbyte(const size_t v) {
+			if(m_size + VBYTE_MAX_BYTES > m_buffer.size()) flush();
+			m_size += write_vbyte(m_buffer.data() + m_size, v);
+		}
+	};
+}
+
 /**
  * Encode a byte-stream with run length encoding
  * each run of the same character is substituted with two occurrences of the same character and the length of the run minus two,
  * encoded in vbyte coding.
+ * The stream is read in blocks, in which the runs and the literals between
+ * them are found eight bytes at a time.
  */
 template<class char_type>
 void rle_encode(std::basic_istream<char_type>& is, std::basic_ostream<char_type>& os, size_t offset = 0) {
-	char_type prev;
-	if(tdc_unlikely(!is.get(prev))) return;
-	os << prev;
-	char_type c;
-	while(is.get(c)) {
-		if(prev == c) {
-			size_t run = 0;
-			while(is.peek() == c) { ++run; is.get(); }
-			os << c;
-			write_vbyte(os, run+offset);
-		} else {
-			os << c;
+	static_assert(sizeof(char_type) == sizeof(uliteral_t), "RLE works on bytes");
+	std::vector<char_type> block(rle::BLOCK_SIZE);
+	rle::OutputBuffer<char_type> out(os);
+
+	bool first = true;
+	bool in_run = false; // whether the run of prev continues into the next block
+	uliteral_t prev = 0;
+	size_t run = 0;
+
+	while(is.read(block.data(), block.size()) || is.gcount() > 0) {
+		const uliteral_t* data = reinterpret_cast<const uliteral_t*>(block.data());
+		const size_t n = is.gcount();
+		size_t i = 0;
+		if(first) {
+			out.put(data[0]);
+			prev = data[0];
+			first = false;
+			i = 1;
+		}
+		while(i < n) {
+			if(in_run) {
+				const size_t end = rle::run_end(data, i, n, prev);
+				run += end - i;
+				i = end;
+				if(i == n) break;
+				out.put_vbyte(run + offset);
+				in_run = false;
+			}
+
+			// the literals up to and including the second character of a run
+			const size_t k = rle::next_pair(data, i, n, prev);
+			out.write(data + i, std::min(k + 1, n) - i);
+			if(k == n) {
+				prev = data[n - 1];
+				i = n;
+			} else {
+				prev = data[k];
+				in_run = true;
+				run = 0;
+				i = k + 1;
+			}
 		}
-		prev = c;
 	}
+	if(in_run) out.put_vbyte(run + offset);
+	out.flush();
 }
 /**
  * Decodes a run length encoded stream
+ * Runs are written with memset into a block-wise output buffer.
  */
 template<class char_type>
 void rle_decode(std::basic_istream<char_type>& is, std::basic_ostream<char_type>& os, size_t offset = 0) {
-	char_type prev;
-	if(tdc_unlikely(!is.get(prev))) return;
-	os << prev;
-	char_type c;
-	while(is.get(c)) {
-		if(prev == c) {
-			size_t run = read_vbyte<size_t>(is)-offset;
-			while(run-- > 0) { os << c; }
+	static_assert(sizeof(char_type) == sizeof(uliteral_t), "RLE works on bytes");
+	// room for a run whose length is cut off by the end of the previous block
+	std::vector<char_type> block(rle::BLOCK_SIZE + 1 + VBYTE_MAX_BYTES);
+	rle::OutputBuffer<char_type> out(os);
+
+	bool first = true;
+	uliteral_t prev = 0;
+	size_t carry = 0;
+
+	for(;;) {
+		is.read(block.data() + carry, rle::BLOCK_SIZE);
+		const size_t read = is.gcount();
+		const size_t n = carry + read;
+		if(n == 0) break;
+
+		const uliteral_t* data = reinterpret_cast<const uliteral_t*>(block.data());
+		size_t i = 0;
+		carry = 0;
+		if(first) {
+			out.put(data[0]);
+			prev = data[0];
+			first = false;
+			i = 1;
+		}
+		while(i < n) {
+			const size_t k = rle::next_pair(data, i, n, prev);
+			if(k == n) {
+				out.write(data + i, n - i);
+				prev = data[n - 1];
+				break;
+			}
+
+			const uliteral_t* p = data + k + 1;
+			size_t run;
+			if(!read_vbyte(p, data + n, run)) {
+				// keep the run for the next block
+				out.write(data + i, k - i);
+				if(k > i) prev = data[k - 1];
+				carry = n - k;
+				CHECK_LE(carry, 1 + VBYTE_MAX_BYTES) << "invalid run length";
+				std::memmove(block.data(), block.data() + k, carry);
+				break;
+			}
+			out.write(data + i, k + 1 - i);
+			out.fill(data[k], run - offset);
+			prev = data[k];
+			i = p - data;
 		}
-		os << c;
-		prev = c;
+
+		if(read == 0) break;
 	}
+	DCHECK_EQ(carry, 0U) << "VByte ended without reading a byte with the most significant bit equals zero.";
+	out.flush();
 }
 
 class RunLengthEncoder : public Compressor {
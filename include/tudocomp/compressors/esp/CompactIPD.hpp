@@ -0,0 +1,159 @@
+#pragma once
+
+#include <tudocomp/Algorithm.hpp>
+#include <tudocomp/ds/IntVector.hpp>
+#include <tudocomp/compressors/esp/HashArray.hpp>
+
+namespace tdc {namespace esp {
+    /// An IPD backed by a bit-packed hash table using linear probing.
+    ///
+    /// The key components and values of all slots are stored in two
+    /// bit-packed arrays. Their widths grow with the largest key component
+    /// and value inserted so far, so keys take only as many bits as the
+    /// alphabet of the current round needs. As there are no per-entry
+    /// allocations or pointers, the table is several times smaller than
+    /// node based maps.
+    class CompactIPD: public Algorithm {
+    public:
+        inline static Meta meta() {
+            Meta m("ipd", "compact");
+            return m;
+        };
+
+        using Algorithm::Algorithm;
+
+        template<size_t N, typename T, typename U>
+        class IPDMap {
+            static constexpr size_t MIN_CAPACITY_LOG2 = 4;
+
+            size_t m_size = 0;
+            size_t m_capacity_log2;
+
+            // the N key components of each slot
+            DynamicIntVector m_keys;
+
+            // the value of each slot plus one, or zero for empty slots
+            DynamicIntVector m_vals;
+
+            inline IPDMap(size_t capacity_log2, size_t key_width, size_t val_width):
+                m_capacity_log2(capacity_log2),
+                m_keys(N << capacity_log2, 0, key_width),
+                m_vals(size_t(1) << capacity_log2, 0, val_width) {}
+
+            inline size_t capacity() const {
+                return size_t(1) << m_capacity_log2;
+            }
+
+            inline size_t home_slot(const Array<N, T>& key) const {
+                uint64_t h = 0;
+                for (size_t i = 0; i < N; i++) {
+                    h = (h ^ uint64_t(key.m_data[i])) * 0x9E3779B97F4A7C15ull;
+                }
+                return h >> (64 - m_capacity_log2);
+            }
+
+            inline bool matches(size_t slot, const Array<N, T>& key) const {
+                for (size_t i = 0; i < N; i++) {
+                    if (uint64_t(m_keys[slot * N + i]) != uint64_t(key.m_data[i])) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            /// Returns the slot containing `key`, or the empty slot
+            /// it would be inserted at.
+            inline size_t find(const Array<N, T>& key) const {
+                const size_t mask = capacity() - 1;
+                size_t slot = home_slot(key);
+                while (uint64_t(m_vals[slot]) != 0 && !matches(slot, key)) {
+                    slot = (slot + 1) & mask;
+                }
+                return slot;
+            }
+
+            inline void rebuild(size_t capacity_log2, size_t key_width, size_t val_width) {
+                IPDMap next(capacity_log2, key_width, val_width);
+
+                for (size_t slot = 0; slot < capacity(); slot++) {
+                    if (uint64_t(m_vals[slot]) == 0) continue;
+
+                    Array<N, T> key = key_at(slot);
+                    const size_t next_slot = next.find(key);
+                    for (size_t i = 0; i < N; i++) {
+                        next.m_keys[next_slot * N + i] = m_keys[slot * N + i];
+                    }
+                    next.m_vals[next_slot] = m_vals[slot];
+                }
+                next.m_size = m_size;
+
+                *this = std::move(next);
+            }
+
+            inline Array<N, T> key_at(size_t slot) const {
+                Array<N, T> key;
+                for (size_t i = 0; i < N; i++) {
+                    key.m_data[i] = T(uint64_t(m_keys[slot * N + i]));
+                }
+                return key;
+            }
+
+        public:
+            inline IPDMap(size_t bucket_count, const Array<N, T>& empty):
+                IPDMap(std::max(size_t(MIN_CAPACITY_LOG2),
+                                size_t(bits_for(bucket_count + bucket_count / 3))),
+                       1, 1) {}
+
+            template<typename Updater>
+            inline U access(const Array<N, T>& key, Updater updater) {
+                size_t key_width = m_keys.width();
+                for (size_t i = 0; i < N; i++) {
+                    key_width = std::max(key_width, size_t(bits_for(uint64_t(key.m_data[i]))));
+                }
+
+                // keep the load factor below 3/4
+                const bool full = (m_size + 1) * 4 > capacity() * 3;
+                if (full || key_width > m_keys.width()) {
+                    rebuild(m_capacity_log2 + (full ? 1 : 0), key_width, m_vals.width());
+                }
+
+                size_t slot = find(key);
+                const bool is_new = uint64_t(m_vals[slot]) == 0;
+
+                U val = is_new ? U() : U(uint64_t(m_vals[slot]) - 1);
+                updater(val);
+
+                const size_t val_width = bits_for(uint64_t(val) + 1);
+                if (val_width > m_vals.width()) {
+                    rebuild(m_capacity_log2, m_keys.width(), val_width);
+                    slot = find(key);
+                }
+
+                if (is_new) {
+                    for (size_t i = 0; i < N; i++) {
+                        m_keys[slot * N + i] = uint64_t(key.m_data[i]);
+                    }
+                    m_size++;
+                }
+                m_vals[slot] = uint64_t(val) + 1;
+
+                return val;
+            }
+
+            inline size_t size() const {
+                return m_size;
+            }
+
+            template<typename F>
+            void for_all(F f) const {
+                for (size_t slot = 0; slot < capacity(); slot++) {
+                    if (uint64_t(m_vals[slot]) == 0) continue;
+
+                    const Array<N, T> key = key_at(slot);
+                    const U val = U(uint64_t(m_vals[slot]) - 1);
+                    f(key, val);
+                }
+            }
+        };
+    };
+}}
@@ -62,6 +62,10 @@ namespace tdc {namespace esp {
         DebugContextBase(const DebugContextBase& other):
             m_data(other.m_data) {}
 
+        bool enabled() const {
+            return bool(m_data);
+        }
+
         void print_all() const {
             if (m_data) {
                 if (!m_data->print_early) {
@@ -33,6 +33,10 @@ namespace tdc {namespace esp {
         bool behavior_landmarks_tie_to_right = true;
         bool behavior_iter_log_mode = false; // UNUSED
 
+        /// The amount of threads used to split and deduplicate the blocks
+        /// of each round. Debug output is only produced with one thread.
+        size_t threads = 1;
+
         template<typename T>
         SLP generate_grammar(T&& s);
     };
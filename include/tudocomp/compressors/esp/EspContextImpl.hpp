@@ -76,12 +76,19 @@ namespace tdc {namespace esp {
             new_layer.width(new_layer_width);
             new_layer.reserve(in.size() / 2 + 1, new_layer_width);
 
-            ctx.split(in);
+            const bool parallel = threads > 1 && !debug.enabled();
+            if (parallel) {
+                ctx.split(in, threads);
+            } else {
+                ctx.split(in);
+            }
 
             const auto& v = ctx.adjusted_blocks();
 
             ctx.debug.slice_symbol_map_start();
-            {
+            if (parallel) {
+                r.gr.add_all(in, v, threads, new_layer);
+            } else {
                 in_t s = in;
                 for (auto e : v) {
                     auto slice = s.slice(0, e.len);
@@ -1,6 +1,12 @@
 #pragma once
 
+#include <mutex>
+#include <unordered_map>
+
+#include <tudocomp/util/parallel.hpp>
+#include <tudocomp/ds/IntVector.hpp>
 #include <tudocomp/compressors/esp/HashArray.hpp>
+#include <tudocomp/compressors/esp/TypedBlock.hpp>
 
 namespace tdc {namespace esp {
     struct IPDStats {
@@ -31,6 +37,37 @@ namespace tdc {namespace esp {
         size_t m_initial_counter = 1;
 
         Stats m_stats;
+
+        /// The amount of shards of the concurrent block map per thread.
+        static constexpr size_t SHARDS_PER_THREAD = 4;
+
+        /// The amount of block ranges per thread processed in parallel.
+        static constexpr size_t RANGES_PER_THREAD = 4;
+
+        /// The first occurrence of a distinct block and the rule for it.
+        ///
+        /// Occurrences are numbered such that the pair of block `b`
+        /// has number `2b` and the triple of block `b` has number `2b + 1`.
+        struct Occurrence {
+            size_t number;
+            size_t pos;
+            size_t rule;
+        };
+
+        /// A part of the concurrent block map, guarded by a mutex.
+        struct Shard {
+            std::mutex mutex;
+            std::unordered_map<Array<2>, Occurrence> pairs;
+            std::unordered_map<Array<3>, Occurrence> triples;
+        };
+
+        template<typename M, typename K>
+        inline static void add_first(M& map, const K& key, Occurrence occ) {
+            auto r = map.emplace(key, occ);
+            if (!r.second && occ.number < r.first->second.number) {
+                r.first->second = occ;
+            }
+        }
     public:
         GrammarRules(size_t counter_start):
             n2(0, Array<2>(default_key())),
@@ -79,6 +116,131 @@ namespace tdc {namespace esp {
             }
         }
 
+        /// Adds the consecutive blocks of `s` with the lengths given in
+        /// `blocks` using `threads` threads, and stores the name of the
+        /// rule for each block relative to the first rule in `names`.
+        ///
+        /// The blocks are deduplicated in parallel through a sharded map,
+        /// and only the first occurrence of each distinct block is added to
+        /// the IPD, in text order. Thus, the rules are the same as if the
+        /// blocks were added one by one.
+        inline void add_all(in_t s,
+                            const std::vector<TypedBlock>& blocks,
+                            size_t threads,
+                            IntVector<dynamic_t>& names) {
+            const size_t b_count = blocks.size();
+            names.resize(b_count);
+            if (b_count == 0) return;
+
+            // Ranges start at multiples of 64 blocks, so that the bit-packed
+            // names of different ranges never share a word.
+            const size_t ranges_wanted = std::max(size_t(1), threads * RANGES_PER_THREAD);
+            const size_t range_size =
+                ((b_count + ranges_wanted - 1) / ranges_wanted + 63) / 64 * 64;
+            const size_t ranges = (b_count + range_size - 1) / range_size;
+
+            std::vector<size_t> range_pos(ranges);
+            size_t size3 = 0;
+            {
+                size_t pos = 0;
+                for (size_t b = 0; b < b_count; b++) {
+                    if (b % range_size == 0) range_pos[b / range_size] = pos;
+                    pos += blocks[b].len;
+                    if (blocks[b].len == 3) size3++;
+                }
+                DCHECK_EQ(pos, s.size());
+            }
+
+            const size_t shard_count = std::max(size_t(1), threads * SHARDS_PER_THREAD);
+            std::vector<Shard> shards(shard_count);
+            auto shard_of = [&](const auto& key) -> Shard& {
+                using key_t = typename std::decay<decltype(key)>::type;
+                return shards[std::hash<key_t>()(key) % shard_count];
+            };
+
+            auto pair_at = [&](size_t pos) {
+                Array<2> key;
+                key.m_data[0] = s[pos];
+                key.m_data[1] = s[pos + 1];
+                return key;
+            };
+            auto triple_at = [&](size_t pos) {
+                Array<3> key;
+                key.m_data[0] = s[pos];
+                key.m_data[1] = s[pos + 1];
+                key.m_data[2] = s[pos + 2];
+                return key;
+            };
+
+            // Find the first occurrence of each distinct block.
+            parallel_for(ranges, threads, [&](size_t k) {
+                std::unordered_map<Array<2>, Occurrence> pairs;
+                std::unordered_map<Array<3>, Occurrence> triples;
+
+                size_t pos = range_pos[k];
+                const size_t end = std::min(b_count, (k + 1) * range_size);
+                for (size_t b = k * range_size; b < end; b++) {
+                    pairs.emplace(pair_at(pos), Occurrence { 2 * b, pos, 0 });
+                    if (blocks[b].len == 3) {
+                        triples.emplace(triple_at(pos), Occurrence { 2 * b + 1, pos, 0 });
+                    }
+                    pos += blocks[b].len;
+                }
+
+                for (auto& kv : pairs) {
+                    auto& shard = shard_of(kv.first);
+                    std::lock_guard<std::mutex> lock(shard.mutex);
+                    add_first(shard.pairs, kv.first, kv.second);
+                }
+                for (auto& kv : triples) {
+                    auto& shard = shard_of(kv.first);
+                    std::lock_guard<std::mutex> lock(shard.mutex);
+                    add_first(shard.triples, kv.first, kv.second);
+                }
+            });
+
+            // Add the first occurrences in text order.
+            std::vector<Occurrence*> firsts;
+            for (auto& shard : shards) {
+                for (auto& kv : shard.pairs) firsts.push_back(&kv.second);
+                for (auto& kv : shard.triples) firsts.push_back(&kv.second);
+            }
+            parallel_sort(firsts.begin(), firsts.end(),
+                [](const Occurrence* a, const Occurrence* b) {
+                    return a->number < b->number;
+                }, threads);
+
+            const Stats stats = m_stats;
+            for (auto occ : firsts) {
+                const size_t len = (occ->number % 2 == 0) ? 2 : 3;
+                occ->rule = add(s.slice(occ->pos, occ->pos + len));
+            }
+            firsts = std::vector<Occurrence*>();
+
+            m_stats.ext_size2_total = stats.ext_size2_total + (b_count - size3);
+            m_stats.ext_size3_total = stats.ext_size3_total + size3;
+            m_stats.int_size2_total = stats.int_size2_total + (b_count - size3) + 2 * size3;
+
+            // Look up the rule of each block.
+            const size_t name_offset = initial_counter() - 1;
+            parallel_for(ranges, threads, [&](size_t k) {
+                size_t pos = range_pos[k];
+                const size_t end = std::min(b_count, (k + 1) * range_size);
+                for (size_t b = k * range_size; b < end; b++) {
+                    size_t rule;
+                    if (blocks[b].len == 3) {
+                        auto key = triple_at(pos);
+                        rule = shard_of(key).triples.find(key)->second.rule;
+                    } else {
+                        auto key = pair_at(pos);
+                        rule = shard_of(key).pairs.find(key)->second.rule;
+                    }
+                    names[b] = rule - name_offset;
+                    pos += blocks[b].len;
+                }
+            });
+        }
+
         inline size_t rules_count() const {
             return counter - m_initial_counter;
         }
@@ -75,5 +75,9 @@ namespace tdc {namespace esp {
         }
 
         void split(round_view_t);
+
+        /// Splits `src` like `split`, but computes the blocks of independent
+        /// chunks of `src` using `threads` threads.
+        void split(round_view_t src, size_t threads);
     };
 }}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <tudocomp/util/parallel.hpp>
 #include <tudocomp/compressors/esp/RoundContext.hpp>
 
 namespace tdc {namespace esp {
@@ -13,6 +14,28 @@ namespace tdc {namespace esp {
         return src.size();
     }
 
+    /// The amount of chunks per thread a round is split into in parallel mode.
+    constexpr size_t SPLIT_CHUNKS_PER_THREAD = 4;
+
+    /// Returns the first position in `[i, j)` at which `split` starts a new
+    /// metablock regardless of the symbols before it, or `src.size()`
+    /// if there is none.
+    ///
+    /// These are the positions right behind a run of at least two equal
+    /// symbols, or the last positions of such runs if repeating metablocks
+    /// are not maximized.
+    template<typename Source>
+    inline size_t independent_split_start(const Source& src, size_t i, size_t j, bool max) {
+        const size_t n = src.size();
+        const size_t end = std::min(n, j + (max ? 0 : 1));
+        for(size_t e = std::max(i + (max ? 0 : 1), size_t(2)); e < end; e++) {
+            if (src[e - 2] == src[e - 1] && src[e - 1] != src[e]) {
+                return max ? e : e - 1;
+            }
+        }
+        return n;
+    }
+
     template<typename round_view_t>
     void RoundContext<round_view_t>::split(round_view_t src) {
         auto& ctx = *this;
@@ -53,4 +76,57 @@ namespace tdc {namespace esp {
             }
         }
     }
+
+    template<typename round_view_t>
+    void RoundContext<round_view_t>::split(round_view_t src, size_t threads) {
+        const size_t n = src.size();
+        const size_t chunks = std::min(n, threads * SPLIT_CHUNKS_PER_THREAD);
+
+        if (threads <= 1 || chunks <= 1) {
+            split(src);
+            return;
+        }
+
+        // Find chunk boundaries at which the metablocks do not depend on
+        // the preceding chunk, so that the chunks can be split independently.
+        std::vector<size_t> bounds(chunks + 1);
+        bounds[0] = 0;
+        bounds[chunks] = n;
+        parallel_for(chunks - 1, threads, [&](size_t c) {
+            bounds[c + 1] = independent_split_start(src,
+                                                    n * (c + 1) / chunks,
+                                                    n * (c + 2) / chunks,
+                                                    behavior_metablocks_maximimze_repeating);
+        });
+        for (size_t c = chunks - 1; c > 0; c--) {
+            bounds[c] = std::min(bounds[c], bounds[c + 1]);
+        }
+
+        std::vector<std::vector<TypedBlock>> chunk_blocks(chunks);
+        parallel_for(chunks, threads, [&](size_t c) {
+            if (bounds[c] == bounds[c + 1]) return;
+
+            auto chunk = src.slice(bounds[c], bounds[c + 1]);
+            RoundContext<round_view_t> chunk_ctx {
+                alphabet_size,
+                chunk,
+                behavior_metablocks_maximimze_repeating,
+                behavior_landmarks_tie_to_right,
+                DebugRoundContext(std::cout, false, false),
+            };
+            chunk_ctx.split(chunk);
+            chunk_blocks[c] = std::move(chunk_ctx.block_buffer);
+        });
+
+        size_t total = 0;
+        for (auto& blocks : chunk_blocks) {
+            total += blocks.size();
+        }
+        block_buffer.reserve(block_buffer.size() + total);
+        for (auto& blocks : chunk_blocks) {
+            block_buffer.insert(block_buffer.end(), blocks.begin(), blocks.end());
+            blocks = std::vector<TypedBlock>();
+        }
+        IF_DEBUG(i += n; last_i = i;)
+    }
 }}
@@ -1,7 +1,9 @@
 #pragma once
 
-#include <memory>
+#include <algorithm>
 #include <array>
+#include <memory>
+#include <vector>
 
 namespace tdc {namespace esp {
     static_assert(sizeof(std::array<size_t, 2>) == sizeof(size_t) * 2, "Something is not right");
@@ -14,6 +16,11 @@ namespace tdc {namespace esp {
         size_t root_rule = 0;
         bool empty = true;
 
+        /// The amount of output kept to copy repeated rules from.
+        static constexpr size_t DERIVE_WINDOW = size_t(1) << 22;
+
+        static constexpr size_t NOT_EXPANDED = size_t(-1);
+
         inline SLP() {}
         inline SLP(std::vector<std::array<size_t, 2>>&& r,
                    size_t root,
@@ -22,21 +29,160 @@ namespace tdc {namespace esp {
             root_rule(root),
             empty(e) {}
 
-        inline void derive_text_rec(std::ostream& o, size_t rule) const {
-            if (rule < 256) {
-                o << char(rule);
-            } else for (auto r : rules[rule - GRAMMAR_PD_ELLIDED_PREFIX]) {
-                derive_text_rec(o, r);
+        /// Returns the length of the expansion of each rule.
+        inline std::vector<size_t> expansion_lengths() const {
+            const size_t P = GRAMMAR_PD_ELLIDED_PREFIX;
+
+            std::vector<size_t> len(rules.size(), 0);
+            std::vector<size_t> stack;
+            for (size_t i = 0; i < rules.size(); i++) {
+                if (len[i] != 0) continue;
+
+                // explicit post-order traversal of the unknown rules
+                stack.push_back(i);
+                while (!stack.empty()) {
+                    const size_t j = stack.back();
+                    if (len[j] != 0) {
+                        stack.pop_back();
+                        continue;
+                    }
+
+                    bool ready = true;
+                    for (auto c : rules[j]) {
+                        if (c >= P && len[c - P] == 0) {
+                            stack.push_back(c - P);
+                            ready = false;
+                        }
+                    }
+                    if (ready) {
+                        for (auto c : rules[j]) {
+                            len[j] += (c < P) ? 1 : len[c - P];
+                        }
+                        stack.pop_back();
+                    }
+                }
             }
+            return len;
         }
 
+        /// Writes the derived text to `o`.
+        ///
+        /// Rules are expanded with an explicit stack into a buffer that
+        /// keeps the last `DERIVE_WINDOW` bytes of output. Each rule
+        /// remembers where it was expanded last, and is copied from there
+        /// instead of being expanded again while that is still buffered.
         inline std::ostream& derive_text(std::ostream& o) const {
-            if (!empty) {
-                derive_text_rec(o, root_rule);
+            const size_t P = GRAMMAR_PD_ELLIDED_PREFIX;
+
+            if (empty) return o;
+            if (root_rule < P) {
+                o.put(char(root_rule));
+                return o;
+            }
+
+            const std::vector<size_t> len = expansion_lengths();
+            std::vector<size_t> last_pos(rules.size(), size_t(NOT_EXPANDED));
+
+            std::vector<char> buf;
+            buf.reserve(2 * DERIVE_WINDOW);
+            size_t buf_off = 0;
+
+            std::vector<size_t> stack { root_rule };
+            while (!stack.empty()) {
+                const size_t sym = stack.back();
+                stack.pop_back();
+
+                if (sym < P) {
+                    buf.push_back(char(sym));
+                } else {
+                    const size_t j = sym - P;
+                    if (last_pos[j] != NOT_EXPANDED && last_pos[j] >= buf_off) {
+                        const size_t from = last_pos[j] - buf_off;
+                        const size_t old_size = buf.size();
+                        buf.resize(old_size + len[j]);
+                        std::copy(buf.begin() + from,
+                                  buf.begin() + from + len[j],
+                                  buf.begin() + old_size);
+                    } else {
+                        last_pos[j] = buf_off + buf.size();
+                        stack.push_back(rules[j][1]);
+                        stack.push_back(rules[j][0]);
+                    }
+                }
+
+                if (buf.size() >= 2 * DERIVE_WINDOW) {
+                    const size_t flush = buf.size() - DERIVE_WINDOW;
+                    o.write(buf.data(), flush);
+                    buf.erase(buf.begin(), buf.begin() + flush);
+                    buf_off += flush;
+                }
             }
+
+            o.write(buf.data(), buf.size());
+            return o;
+        }
+
+        /// Writes the `len` characters of the derived text starting at
+        /// position `from` to `o`, or less if the text ends before.
+        ///
+        /// Given the `lengths` of all rules (see `expansion_lengths`), this
+        /// takes time linear in the height of the grammar plus `len`.
+        inline std::ostream& extract(std::ostream& o,
+                                     size_t from,
+                                     size_t len,
+                                     const std::vector<size_t>& lengths) const {
+            const size_t P = GRAMMAR_PD_ELLIDED_PREFIX;
+
+            auto length_of = [&](size_t sym) {
+                return (sym < P) ? size_t(1) : lengths[sym - P];
+            };
+
+            if (empty || len == 0 || from >= length_of(root_rule)) return o;
+
+            // descend to the first character, remembering the right
+            // siblings that follow it
+            std::vector<size_t> stack;
+            size_t sym = root_rule;
+            while (sym >= P) {
+                const auto& rule = rules[sym - P];
+                const size_t left_len = length_of(rule[0]);
+                if (from < left_len) {
+                    stack.push_back(rule[1]);
+                    sym = rule[0];
+                } else {
+                    from -= left_len;
+                    sym = rule[1];
+                }
+            }
+            stack.push_back(sym);
+
+            std::vector<char> buf;
+            buf.reserve(std::min(len, size_t(DERIVE_WINDOW)));
+            while (len > 0 && !stack.empty()) {
+                sym = stack.back();
+                stack.pop_back();
+
+                if (sym < P) {
+                    buf.push_back(char(sym));
+                    len--;
+                    if (buf.size() == DERIVE_WINDOW) {
+                        o.write(buf.data(), buf.size());
+                        buf.clear();
+                    }
+                } else {
+                    stack.push_back(rules[sym - P][1]);
+                    stack.push_back(rules[sym - P][0]);
+                }
+            }
+
+            o.write(buf.data(), buf.size());
             return o;
         }
 
+        inline std::ostream& extract(std::ostream& o, size_t from, size_t len) const {
+            return extract(o, from, len, expansion_lengths());
+        }
+
         inline std::string derive_text_s() const {
             std::stringstream ss;
             derive_text(ss);
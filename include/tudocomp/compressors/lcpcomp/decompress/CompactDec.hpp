@@ -122,7 +122,7 @@ public:
     })
 
     inline void write_to(std::ostream& out) const {
-        for(auto c : m_buffer) out << c;
+        out.write((const char*) m_buffer.data(), m_buffer.size());
     }
 };
 
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+#include <tudocomp/def.hpp>
+#include <tudocomp/ds/IntVector.hpp>
+#include <tudocomp/Algorithm.hpp>
+#include <tudocomp/util/parallel.hpp>
+
+namespace tdc {
+namespace lcpcomp {
+
+/**
+ * Decodes lcpcomp compressed data with multiple threads.
+ *
+ * Each position of the text either holds a literal or references the
+ * position it is copied from. These references form a forest whose roots
+ * are the literals. Instead of following the chains one by one, the
+ * decoder lets every position jump to the reference of its reference
+ * until all of them point to a literal. All positions of a round are
+ * independent of each other, so each round is split between the
+ * `threads` (0 for one per hardware thread), and the longest chain is
+ * resolved in logarithmically many rounds. Finally, all characters are
+ * copied from their literals in parallel.
+ *
+ * The references are tracked per position rather than per factor, as the
+ * source of a factor may overlap with its own target or with factors
+ * that in turn reference it.
+ */
+class ParallelDec : public Algorithm {
+public:
+    inline static Meta meta() {
+        Meta m("lcpcomp_dec", "parallel");
+        m.option("threads").dynamic(0);
+        return m;
+    }
+
+    inline void decode_lazy() const {
+    }
+
+    inline void decode_eagerly() {
+        const size_t n = m_buffer.size();
+        const size_t chunks = (n + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+        std::vector<len_compact_t> next(n);
+        IF_STATS(std::vector<len_compact_t> next_dist(n));
+
+        // every round at least doubles the length of the jumps, so a chain
+        // of length l is resolved after at most log(l) + 1 rounds
+        for(size_t round = 0;; ++round) {
+            CHECK_LE(round, size_t(bits_for(n))) << "cyclic references";
+
+            std::vector<char> changed(chunks, 0);
+            parallel_for(chunks, m_threads, [&](size_t c) {
+                const size_t end = std::min(n, (c + 1) * CHUNK_SIZE);
+                for(size_t i = c * CHUNK_SIZE; i < end; ++i) {
+                    const len_compact_t ref = m_ref[i];
+                    next[i] = m_ref[ref];
+                    IF_STATS(next_dist[i] = m_dist[i] + m_dist[ref]);
+                    changed[c] |= (next[i] != ref);
+                }
+            });
+            std::swap(m_ref, next);
+            IF_STATS(std::swap(m_dist, next_dist));
+
+            if(std::find(changed.begin(), changed.end(), 1) == changed.end()) {
+                break;
+            }
+        }
+        IF_STATS(for(size_t i = 0; i < n; ++i) {
+            m_longest_chain = std::max<len_t>(m_longest_chain, m_dist[i]);
+        })
+
+        // the targets are disjoint from the literals they are read from
+        parallel_for(chunks, m_threads, [&](size_t c) {
+            const size_t end = std::min(n, (c + 1) * CHUNK_SIZE);
+            for(size_t i = c * CHUNK_SIZE; i < end; ++i) {
+                if(m_ref[i] != i) m_buffer[i] = m_buffer[m_ref[i]];
+            }
+        });
+
+        m_ref = std::vector<len_compact_t>();
+        IF_STATS(m_dist = std::vector<len_compact_t>());
+    }
+
+private:
+    static constexpr size_t CHUNK_SIZE = 1ULL << 16;
+
+    size_t m_threads;
+    len_t m_cursor;
+    IF_STATS(len_t m_longest_chain);
+
+    // the amount of references followed by the current jump of each position
+    IF_STATS(std::vector<len_compact_t> m_dist);
+
+    // the position each position is copied from, or itself for literals
+    std::vector<len_compact_t> m_ref;
+
+    IntVector<uliteral_t> m_buffer;
+
+public:
+    inline ParallelDec(Env&& env, len_t size)
+        : Algorithm(std::move(env)), m_cursor(0), m_ref(size), m_buffer(size, 0) {
+
+        m_threads = this->env().option("threads").as_integer();
+        if(m_threads == 0) m_threads = hardware_threads();
+
+        IF_STATS(m_longest_chain = 0);
+        IF_STATS(m_dist.resize(size));
+    }
+
+    inline void decode_literal(uliteral_t c) {
+        DCHECK_LT(m_cursor, m_buffer.size());
+        m_buffer[m_cursor] = c;
+        m_ref[m_cursor] = m_cursor;
+        ++m_cursor;
+    }
+
+    inline void decode_factor(len_t pos, len_t num) {
+        DCHECK_LE(m_cursor + num, m_buffer.size());
+        for(len_t i = 0; i < num; i++) {
+            IF_STATS(m_dist[m_cursor] = 1);
+            m_ref[m_cursor++] = pos + i;
+        }
+    }
+
+    IF_STATS(
+    inline len_t longest_chain() const {
+        return m_longest_chain;
+    })
+
+    inline void write_to(std::ostream& out) const {
+        out.write((const char*) m_buffer.data(), m_buffer.size());
+    }
+};
+
+}} //ns
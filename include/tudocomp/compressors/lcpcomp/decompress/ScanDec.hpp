@@ -138,16 +138,143 @@ namespace lcpcomp {
 
 	};
 
+	/**
+	 * Finishes the process of decoding started by @class ScanDec like
+	 * @class EagerScanDec, but stores the positions waiting for a
+	 * not-yet decoded position in a single array of contiguous lists
+	 * instead of allocating a dynamic array for each position.
+	 * In a first pass over the factors, it counts the waiting positions of
+	 * each not-yet decoded position to compute the offsets of the lists,
+	 * and fills them in a second pass. A third pass copies the characters
+	 * of already decoded sources and propagates them along the waiting lists.
+	 */
+	class CountingEagerScanDec {
+		IntVector<uliteral_t>& m_buffer;
+		const sdsl::bit_vector m_bv;
+		const sdsl::bit_vector::rank_1_type m_rank;
+		const len_t m_empty_entries;
+
+		// the list of the i-th not-yet decoded position is
+		// m_waiting[m_offsets[i]..m_offsets[i+1])
+		std::vector<len_compact_t> m_offsets;
+		std::vector<len_compact_t> m_waiting;
+
+		// positions whose waiting lists still have to be decoded
+		std::vector<len_compact_t> m_stack;
+
+		IF_STATS(len_t m_longest_chain = 0);
+		IF_STATS(std::vector<len_compact_t> m_depths);
+
+		len_t rank(len_t i) const {
+			DCHECK(m_bv[i]);
+			return m_rank.rank(i);
+		}
+
+		/// Calls `f(target, source)` for all pairs of a target position
+		/// and its source of which at least the target is not yet decoded.
+		template<typename F>
+		void for_each_target(const std::vector<len_compact_t>& m_target_pos, const std::vector<len_compact_t>& m_source_pos, const std::vector<len_compact_t>& m_length, F f) const {
+			const len_t factors = m_source_pos.size();
+			for(len_t j = 0; j < factors; ++j) {
+				for(len_t i = 0; i < m_length[j]; ++i) {
+					if(m_bv[m_target_pos[j]+i]) f(m_target_pos[j]+i, m_source_pos[j]+i);
+				}
+			}
+		}
+
+		public:
+		CountingEagerScanDec(Env&, IntVector<uliteral_t>& buffer)
+			: m_buffer { buffer }
+			, m_bv ( [&buffer] () -> sdsl::bit_vector {
+				sdsl::bit_vector bv { buffer.size(),0 };
+				for(len_t i = 0; i < buffer.size(); ++i) {
+					if(buffer[i]) continue;
+					bv[i] = 1;
+				}
+				return bv;
+			}() )
+			, m_rank { &m_bv }
+			, m_empty_entries { static_cast<len_t>(std::count_if(buffer.cbegin(), buffer.cend(), [] (const uliteral_t& i) { return i == 0; })) }
+		{
+		}
+
+		void decode(const std::vector<len_compact_t>& m_target_pos, const std::vector<len_compact_t>& m_source_pos, const std::vector<len_compact_t>& m_length) {
+			StatPhase phase("Counting Waiting Positions");
+			phase.log_stat("factors", m_source_pos.size());
+
+			m_offsets.assign(m_empty_entries+1, 0);
+			for_each_target(m_target_pos, m_source_pos, m_length, [&](len_t, len_t source) {
+				if(m_bv[source]) ++m_offsets[rank(source)+1];
+			});
+			for(len_t i = 1; i <= m_empty_entries; ++i) {
+				m_offsets[i] += m_offsets[i-1];
+			}
+
+			phase.split("Filling Waiting Lists");
+			m_waiting.resize(m_offsets[m_empty_entries]);
+			phase.log_stat("waiting", m_waiting.size());
+
+			// m_offsets[i] is advanced to the end of the i-th list, which is
+			// the start of the next one, and shifted back afterwards
+			for_each_target(m_target_pos, m_source_pos, m_length, [&](len_t target, len_t source) {
+				if(m_bv[source]) m_waiting[m_offsets[rank(source)]++] = target;
+			});
+			for(len_t i = m_empty_entries; i > 0; --i) {
+				m_offsets[i] = m_offsets[i-1];
+			}
+			m_offsets[0] = 0;
+
+			phase.split("Decoding Factors");
+			for_each_target(m_target_pos, m_source_pos, m_length, [&](len_t target, len_t source) {
+				if(!m_bv[source]) decode_literal_at(target, m_buffer[source]);
+			});
+		}
+
+		/// Decodes `pos` and all positions waiting for it, directly or
+		/// transitively, with the character `c`.
+		inline void decode_literal_at(len_t pos, uliteral_t c) {
+			DCHECK(c != 0 || pos == m_buffer.size()-1); // we assume that the text to restore does not contain a NULL-byte but at its very end
+
+			m_buffer[pos] = c;
+			m_stack.push_back(pos);
+			IF_STATS(m_depths.push_back(1));
+
+			while(!m_stack.empty()) {
+				const len_t rankpos = rank(m_stack.back());
+				m_stack.pop_back();
+				IF_STATS(const len_t depth = m_depths.back());
+				IF_STATS(m_depths.pop_back());
+				IF_STATS(m_longest_chain = std::max(m_longest_chain, depth));
+
+				for(len_t i = m_offsets[rankpos]; i < m_offsets[rankpos+1]; ++i) {
+					DCHECK_EQ(m_buffer[m_waiting[i]], 0);
+					m_buffer[m_waiting[i]] = c;
+					m_stack.push_back(m_waiting[i]);
+					IF_STATS(m_depths.push_back(depth+1));
+				}
+			}
+		}
+
+		IF_STATS(
+		inline len_t longest_chain() const {
+			return m_longest_chain;
+		})
+	};
+
 	/**
 	 * Runs a number of scans of the factors.
 	 * In each scan, it tries to decode all factors.
 	 * Factors that got fully decoded are dropped.
+	 * The remaining factors are decoded with the "eager" strategy:
+	 * "buckets" for @class EagerScanDec or "counting"
+	 * for @class CountingEagerScanDec.
 	 */
 class ScanDec : public Algorithm {
 public:
     inline static Meta meta() {
         Meta m("lcpcomp_dec", "scan");
         m.option("scans").dynamic(6);
+        m.option("eager").dynamic("buckets");
         return m;
 
     }
@@ -161,8 +288,20 @@ public:
         }
     }
     inline void decode_eagerly() {
-        EagerScanDec* decoder = StatPhase::wrap("Initialize Bit Vector", [&]{
-            return new EagerScanDec(this->env(),m_buffer);
+        const std::string eager = this->env().option("eager").as_string();
+        if(eager == "counting") {
+            decode_eagerly_<CountingEagerScanDec>();
+        } else {
+            CHECK(eager == "buckets") << "unknown eager decoding strategy: " << eager;
+            decode_eagerly_<EagerScanDec>();
+        }
+    }
+
+private:
+    template<typename eager_t>
+    inline void decode_eagerly_() {
+        eager_t* decoder = StatPhase::wrap("Initialize Bit Vector", [&]{
+            return new eager_t(this->env(),m_buffer);
         });
 
         decoder->decode(m_target_pos, m_source_pos, m_length);
@@ -173,7 +312,6 @@ public:
         });
     }
 
-private:
     inline void decode_lazy_() {
         const len_t factors = m_source_pos.size();
         for(len_t j = 0; j < factors; ++j) {
@@ -242,7 +380,7 @@ public:
     })
 
     inline void write_to(std::ostream& out) const {
-        for(auto c : m_buffer) out << c;
+        out.write((const char*) m_buffer.data(), m_buffer.size());
     }
 };
 
@@ -16,6 +16,11 @@ constexpr factorid_t undef_id = std::numeric_limits<factorid_t>::max();
 /// Maximum legal dictionary size.
 constexpr size_t DMS_MAX = std::numeric_limits<factorid_t>::max();
 
+/// Text length passed to the tries if the input size is not known in
+/// advance. It makes the estimated amount of remaining factors large,
+/// so the tries double their size whenever they grow.
+constexpr size_t UNKNOWN_TEXT_SIZE = std::numeric_limits<size_t>::max() / 4;
+
 // NB: Also update the Lz78 chapter in the docs in case of changes to this file
 
 /// Default return type of find_or_insert
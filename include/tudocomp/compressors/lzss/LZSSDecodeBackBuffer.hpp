@@ -34,7 +34,7 @@ public:
     }
 
     inline void write_to(std::ostream& out) {
-        for(auto c : m_buffer) out << c;
+        out.write((const char*) m_buffer.data(), m_buffer.size());
     }
 };
 
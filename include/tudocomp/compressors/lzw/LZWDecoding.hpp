@@ -1,5 +1,11 @@
 #pragma once
 
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
 #include <tudocomp/util.hpp>
 #include <tudocomp/compressors/lz78/LZ78Trie.hpp>
 #include <tudocomp/compressors/lzw/LZWFactor.hpp>
@@ -9,48 +15,49 @@ namespace lzw {
 
 using CodeType = lz78::factorid_t;
 
+/// Decodes LZW codes, calling next_code_callback for each code.
+///
+/// The text decoded since the last dictionary reset is kept in a buffer.
+/// Each dictionary entry beyond the single characters consists of a
+/// previously decoded string and the character following it in the text,
+/// so it is stored as a position and length in the buffer, and decoding a
+/// code copies the entry in one go.
 template<class F>
 void decode_step(F next_code_callback,
                  std::ostream& out,
                  const CodeType dms,
                  const CodeType reserve_dms) {
-    std::vector<std::pair<CodeType, uliteral_t>> dictionary;
-
-    // "named" lambda function, used to reset the dictionary to its initial contents
-    const auto reset_dictionary = [&] {
-        dictionary.clear();
-        dictionary.reserve(reserve_dms);
+    constexpr size_t num_chars = size_t(std::numeric_limits<uliteral_t>::max()) + 1;
 
-        const long int minc = std::numeric_limits<uliteral_t>::min();
-        const long int maxc = std::numeric_limits<uliteral_t>::max();
+    // entries of the dictionary after the single characters
+    std::vector<std::pair<size_t, size_t>> dictionary;
+    std::vector<uliteral_t> text;
+    text.reserve(reserve_dms);
 
-        for (long int c = minc; c <= maxc; ++c)
-            dictionary.push_back({dms, static_cast<uliteral_t> (c)});
+    const auto dictionary_size = [&] {
+        return dictionary.size() + num_chars;
     };
 
-    const auto rebuild_string = [&](CodeType k) -> const std::vector<uliteral_t> * {
-        static std::vector<uliteral_t> s; // String
-
-        s.clear();
-
-        // the length of a string cannot exceed the dictionary's number of entries
-        s.reserve(reserve_dms);
-
-        while (k != dms)
-        {
-            s.push_back(dictionary[k].second);
-            k = dictionary[k].first;
-        }
-
-        std::reverse(s.begin(), s.end());
-        return &s;
+    size_t prev_pos = 0; // position of the previously decoded string
+    size_t prev_len = 0; // its length, 0 if there is none
+    size_t written = 0;  // the amount of characters of text already written
+
+    // "named" lambda function, writes the text and resets the dictionary
+    // to its initial contents
+    //
+    // The previously decoded string is kept at the start of the buffer:
+    // the encoder resets its dictionary before it encodes that string, so
+    // together with the next one it forms the first entry of the new
+    // dictionary.
+    const auto reset_dictionary = [&] {
+        out.write((const char*) text.data() + written, text.size() - written);
+        std::memmove(text.data(), text.data() + prev_pos, prev_len);
+        text.resize(prev_len);
+        written = prev_len;
+        prev_pos = 0;
+        dictionary.clear();
     };
 
-    reset_dictionary();
-
-    CodeType i {dms}; // Index
-    CodeType k; // Key
-
     bool corrupted = false;
 
     while (true)
@@ -58,42 +65,52 @@ void decode_step(F next_code_callback,
         bool dictionary_reset = false;
 
         // dictionary's maximum size was reached
-        if (dictionary.size() == dms)
+        if (dictionary_size() == dms)
         {
             reset_dictionary();
             dictionary_reset = true;
         }
 
+        CodeType k; // Key
         if (!next_code_callback(k, dictionary_reset, corrupted))
             break;
 
-        //std::cout << byte_to_nice_ascii_char(k) << "\n";
-
-        if (k > dictionary.size()) {
+        if (k > dictionary_size() || (k == dictionary_size() && prev_len == 0)) {
             std::stringstream s;
             s << "invalid compressed code " << k;
             throw std::runtime_error(s.str());
         }
 
-        const std::vector<uliteral_t> *s; // String
-
-        if (k == dictionary.size())
+        const size_t pos = text.size();
+        if (k < num_chars)
         {
-            dictionary.push_back({i, rebuild_string(i)->front()});
-            s = rebuild_string(k);
+            text.push_back(uliteral_t(k));
+        }
+        else if (k < dictionary_size())
+        {
+            const auto& entry = dictionary[k - num_chars];
+            text.resize(pos + entry.second);
+            std::memcpy(text.data() + pos, text.data() + entry.first, entry.second);
         }
         else
         {
-            s = rebuild_string(k);
-
-            if (i != dms)
-                dictionary.push_back({i, s->front()});
+            // the entry to be added: the previous string and its first character
+            text.resize(pos + prev_len + 1);
+            std::memcpy(text.data() + pos, text.data() + prev_pos, prev_len);
+            text[pos + prev_len] = text[prev_pos];
         }
 
-        out.write((char*) &s->front(), s->size());
-        i = k;
+        // the previous string is followed by the first character of the
+        // current one, so the new entry is consecutive in the text
+        if (prev_len > 0)
+            dictionary.push_back({prev_pos, prev_len + 1});
+
+        prev_pos = pos;
+        prev_len = text.size() - pos;
     }
 
+    out.write((const char*) text.data() + written, text.size() - written);
+
     if (corrupted)
         throw std::runtime_error("corrupted compressed file");
 }
@@ -0,0 +1,423 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <tudocomp/def.hpp>
+#include <tudocomp/util.hpp>
+#include <tudocomp/ds/IntVector.hpp>
+
+namespace tdc {
+namespace repair {
+
+using sym_t = uint32_t;
+using digram_t = uint64_t;
+using grammar_t = std::vector<digram_t>;
+
+constexpr size_t digram_shift = 32UL;
+
+inline digram_t digram(sym_t l, sym_t r) {
+    return (digram_t(l) << digram_shift) | digram_t(r);
+}
+
+inline sym_t left(digram_t di) {
+    return sym_t(di >> digram_shift);
+}
+
+inline sym_t right(digram_t di) {
+    return sym_t(di);
+}
+
+/// Returns the length of the expansion of each rule, where rule `i`
+/// defines symbol `sigma + i`.
+inline std::vector<size_t> expansion_lengths(const grammar_t& grammar, size_t sigma) {
+    std::vector<size_t> lengths(grammar.size());
+    auto length_of = [&](sym_t x) {
+        return (x < sigma) ? size_t(1) : lengths[x - sigma];
+    };
+
+    // rules only refer to earlier rules
+    for(size_t i = 0; i < grammar.size(); i++) {
+        lengths[i] = length_of(left(grammar[i])) + length_of(right(grammar[i]));
+    }
+    return lengths;
+}
+
+/// Writes the `len` characters of the expansion of symbol `x` starting at
+/// position `from` to `out`, or less if the expansion ends before.
+///
+/// Takes time linear in the height of the grammar plus `len`.
+inline void extract(std::ostream& out,
+                    const grammar_t& grammar,
+                    const std::vector<size_t>& lengths,
+                    size_t sigma,
+                    sym_t x,
+                    size_t from,
+                    size_t len) {
+    auto length_of = [&](sym_t y) {
+        return (y < sigma) ? size_t(1) : lengths[y - sigma];
+    };
+    if(len == 0 || from >= length_of(x)) return;
+
+    // descend to the first character, remembering the right siblings
+    std::vector<sym_t> stack;
+    while(x >= sigma) {
+        const digram_t di = grammar[x - sigma];
+        const size_t left_len = length_of(left(di));
+        if(from < left_len) {
+            stack.push_back(right(di));
+            x = left(di);
+        } else {
+            from -= left_len;
+            x = right(di);
+        }
+    }
+    stack.push_back(x);
+
+    const size_t buf_size = 1 << 16;
+    std::string buf;
+    buf.reserve(std::min(len, buf_size));
+    while(len > 0 && !stack.empty()) {
+        x = stack.back();
+        stack.pop_back();
+
+        if(x < sigma) {
+            buf.push_back(char(x));
+            --len;
+            if(buf.size() == buf_size) {
+                out.write(buf.data(), buf.size());
+                buf.clear();
+            }
+        } else {
+            const digram_t di = grammar[x - sigma];
+            stack.push_back(right(di));
+            stack.push_back(left(di));
+        }
+    }
+    out.write(buf.data(), buf.size());
+}
+
+/// \cond INTERNAL
+template<typename T>
+inline std::vector<T> make_array(std::vector<T>*, size_t n, size_t) {
+    return std::vector<T>(n);
+}
+
+inline DynamicIntVector make_array(DynamicIntVector*, size_t n, size_t width) {
+    return DynamicIntVector(n, 0, width);
+}
+
+template<typename T>
+inline bool fits_array(std::vector<T>*, size_t x) {
+    return x <= size_t(std::numeric_limits<T>::max());
+}
+
+inline bool fits_array(DynamicIntVector*, size_t) {
+    return true; // the width is chosen from the largest value
+}
+/// \endcond
+
+/// Computes a RePair grammar in linear time following Larsson and Moffat,
+/// "Off-line dictionary-based compression".
+///
+/// The text is rewritten in-place. Replaced positions become holes, and
+/// runs of holes store the positions of the surrounding symbols at their
+/// borders, so that the remaining sequence can be traversed in constant
+/// time. The occurrences of each digram are kept in a doubly linked list
+/// and the digrams are ordered by their frequency in buckets. Frequencies
+/// of at least `sqrt(n)` share a single bucket that is searched for the
+/// maximum, which is cheap because there can only be few such digrams.
+/// Overlapping occurrences of a digram (as in `aaa`) are counted once.
+///
+/// The symbols and the links are stored in arrays of type `seq_t` and
+/// `link_t`, respectively, which are either `std::vector`s or bit-packed
+/// `DynamicIntVector`s. Their values include sentinels up to `sigma + n`
+/// and `n + 2`, respectively, so fixed-width elements limit the text length.
+///
+/// The digram records are not bit-packed in either case. Each takes 40
+/// bytes, plus a node of the hash map that indexes them, and there is one
+/// record per distinct digram. On texts with many distinct digrams, they
+/// can take more space than the arrays.
+template<typename seq_t, typename link_t>
+class Grammar {
+    /// A digram with its frequency and list of occurrences.
+    struct Record {
+        digram_t di;
+        size_t count;
+        size_t head;         // first occurrence
+        size_t prev, next;   // neighbours in the frequency bucket
+    };
+
+    static constexpr size_t NO_REC = SIZE_MAX;
+
+    const size_t m_n;
+    const size_t m_sigma;
+
+    const size_t NONE;      // no position
+    const size_t UNLINKED;  // position not in an occurrence list
+    const size_t HOLE;      // symbol of replaced positions
+
+    seq_t m_seq;
+    // For each position in an occurrence list, the previous and next
+    // occurrence of the same digram. The first and last position of a run
+    // of holes store the position after and before the run, respectively.
+    link_t m_prev;
+    link_t m_next;
+
+    std::vector<Record> m_rec;
+    std::vector<size_t> m_free;
+    std::unordered_map<digram_t, size_t> m_map;
+
+    const size_t m_top; // frequencies of at least m_top share a bucket
+    std::vector<size_t> m_bucket;
+    size_t m_cursor;
+    size_t m_current = NO_REC; // the digram being replaced
+
+    grammar_t m_grammar;
+    size_t m_replaced = 0;
+
+    inline size_t sym(size_t i) const {
+        return m_seq[i];
+    }
+
+    inline size_t next_pos(size_t i) const {
+        const size_t k = i + 1;
+        return (k < m_n && sym(k) == HOLE) ? size_t(m_next[k]) : k;
+    }
+
+    inline size_t prev_pos(size_t i) const {
+        if(i == 0) return NONE;
+        const size_t k = i - 1;
+        return (sym(k) == HOLE) ? size_t(m_prev[k]) : k;
+    }
+
+    inline bool is_linked(size_t i) const {
+        return size_t(m_prev[i]) != UNLINKED;
+    }
+
+    inline size_t bucket_of(size_t count) const {
+        return std::min(count, m_top);
+    }
+
+    inline void bucket_insert(size_t r) {
+        Record& rec = m_rec[r];
+        if(r == m_current || rec.count < 2) return;
+
+        const size_t b = bucket_of(rec.count);
+        rec.prev = NO_REC;
+        rec.next = m_bucket[b];
+        if(rec.next != NO_REC) m_rec[rec.next].prev = r;
+        m_bucket[b] = r;
+    }
+
+    inline void bucket_remove(size_t r) {
+        Record& rec = m_rec[r];
+        if(r == m_current || rec.count < 2) return;
+
+        if(rec.prev != NO_REC) m_rec[rec.prev].next = rec.next;
+        else m_bucket[bucket_of(rec.count)] = rec.next;
+        if(rec.next != NO_REC) m_rec[rec.next].prev = rec.prev;
+    }
+
+    inline size_t new_record(digram_t di) {
+        size_t r;
+        if(m_free.empty()) {
+            r = m_rec.size();
+            m_rec.emplace_back();
+        } else {
+            r = m_free.back();
+            m_free.pop_back();
+        }
+        m_rec[r] = Record { di, 0, NONE, NO_REC, NO_REC };
+        m_map.emplace(di, r);
+        return r;
+    }
+
+    inline void free_record(size_t r) {
+        m_map.erase(m_rec[r].di);
+        m_free.push_back(r);
+    }
+
+    /// Adds the digram starting at position i to the occurrence lists.
+    inline void add(size_t i) {
+        const size_t j = next_pos(i);
+        if(j >= m_n) return;
+
+        const size_t a = sym(i);
+        const size_t b = sym(j);
+        if(a == b) {
+            // do not count overlapping occurrences
+            const size_t h = prev_pos(i);
+            if(h != NONE && sym(h) == a && is_linked(h)) return;
+
+            const size_t k = next_pos(j);
+            if(k < m_n && sym(k) == a && is_linked(j)) return;
+        }
+
+        const digram_t di = digram(a, b);
+        auto it = m_map.find(di);
+        const size_t r = (it != m_map.end()) ? it->second : new_record(di);
+
+        // prepend to the occurrence list
+        const size_t head = m_rec[r].head;
+        m_prev[i] = NONE;
+        m_next[i] = head;
+        if(head != NONE) m_prev[head] = i;
+        m_rec[r].head = i;
+
+        bucket_remove(r);
+        ++m_rec[r].count;
+        bucket_insert(r);
+    }
+
+    /// Removes the digram starting at position i from the occurrence lists.
+    inline void remove(size_t i) {
+        if(!is_linked(i)) return;
+
+        const digram_t di = digram(sym(i), sym(next_pos(i)));
+        const size_t r = m_map.find(di)->second;
+
+        const size_t prev = m_prev[i];
+        const size_t next = m_next[i];
+        if(prev != NONE) m_next[prev] = next;
+        else m_rec[r].head = next;
+        if(next != NONE) m_prev[next] = prev;
+        m_prev[i] = UNLINKED;
+
+        bucket_remove(r);
+        --m_rec[r].count;
+        bucket_insert(r);
+
+        if(m_rec[r].count == 0 && r != m_current) free_record(r);
+    }
+
+    /// Turns position j into a hole, merging it with adjacent holes.
+    inline void make_hole(size_t j) {
+        DCHECK_GT(j, 0U);
+
+        size_t a = j, b = j;
+        if(sym(j - 1) == HOLE) a = size_t(m_prev[j - 1]) + 1;
+        if(j + 1 < m_n && sym(j + 1) == HOLE) b = size_t(m_next[j + 1]) - 1;
+
+        m_seq[j] = HOLE;
+        m_next[a] = b + 1;
+        m_prev[b] = a - 1;
+    }
+
+    /// Returns the most frequent digram, or NO_REC if there is no
+    /// digram occurring at least twice.
+    inline size_t max_record() {
+        size_t best = NO_REC;
+        for(size_t r = m_bucket[m_top]; r != NO_REC; r = m_rec[r].next) {
+            if(best == NO_REC || m_rec[r].count > m_rec[best].count) best = r;
+        }
+        if(best != NO_REC) return best;
+
+        // frequencies never exceed that of the last replaced digram
+        while(m_cursor >= 2 && m_bucket[m_cursor] == NO_REC) --m_cursor;
+        return (m_cursor >= 2) ? m_bucket[m_cursor] : NO_REC;
+    }
+
+    /// Replaces all occurrences of the digram r by a new symbol.
+    inline void replace(size_t r) {
+        bucket_remove(r);
+        m_current = r;
+
+        const size_t x = m_sigma + m_grammar.size();
+        m_grammar.push_back(m_rec[r].di);
+
+        while(m_rec[r].head != NONE) {
+            const size_t i = m_rec[r].head;
+            const size_t j = next_pos(i);
+            const size_t h = prev_pos(i);
+            const size_t k = next_pos(j);
+
+            // remove the digrams that are affected
+            remove(i);
+            if(h != NONE) remove(h);
+            if(k < m_n) remove(j);
+
+            m_seq[i] = x;
+            make_hole(j);
+            ++m_replaced;
+
+            // add the digrams containing the new symbol
+            if(h != NONE) add(h);
+            if(k < m_n) add(i);
+
+            // occurrences next to the replaced ones may no longer overlap
+            if(h != NONE) {
+                const size_t g = prev_pos(h);
+                if(g != NONE && !is_linked(g)) add(g);
+            }
+            if(k < m_n && !is_linked(k)) add(k);
+        }
+
+        m_current = NO_REC;
+        free_record(r);
+    }
+
+public:
+    /// Computes the grammar for `text` of length `n` over the alphabet
+    /// `[0, sigma)`, creating at most `max_rules` rules.
+    template<typename text_t>
+    inline Grammar(const text_t& text, size_t n, size_t sigma, size_t max_rules)
+        : m_n(n),
+          m_sigma(sigma),
+          NONE(n + 1),
+          UNLINKED(n + 2),
+          HOLE(sigma + n),
+          m_seq(make_array((seq_t*) nullptr, n, bits_for(HOLE))),
+          m_prev(make_array((link_t*) nullptr, n, bits_for(UNLINKED))),
+          m_next(make_array((link_t*) nullptr, n, bits_for(UNLINKED))),
+          m_top(std::max(size_t(3), size_t(std::sqrt(double(n))))),
+          m_bucket(m_top + 1, NO_REC),
+          m_cursor(m_top - 1) {
+
+        CHECK(fits_array((seq_t*) nullptr, HOLE) &&
+              fits_array((link_t*) nullptr, UNLINKED))
+            << "the text is too long for the symbol and link types";
+
+        for(size_t i = 0; i < n; i++) {
+            m_seq[i] = sym_t(text[i]);
+            m_prev[i] = UNLINKED;
+        }
+
+        for(size_t i = 0; i < n; i++) add(i);
+
+        while(m_grammar.size() < max_rules) {
+            const size_t r = max_record();
+            if(r == NO_REC) break;
+            replace(r);
+        }
+    }
+
+    /// The grammar rules, rule `i` defines symbol `sigma + i`.
+    inline const grammar_t& grammar() const {
+        return m_grammar;
+    }
+
+    /// The amount of replaced digram occurrences.
+    inline size_t replaced() const {
+        return m_replaced;
+    }
+
+    /// Returns the rewritten text (start rule).
+    inline std::vector<sym_t> sequence() const {
+        std::vector<sym_t> seq;
+        for(size_t i = 0; i < m_n; i = next_pos(i)) {
+            seq.push_back(sym_t(sym(i)));
+        }
+        return seq;
+    }
+};
+
+template<typename seq_t, typename link_t>
+constexpr size_t Grammar<seq_t, link_t>::NO_REC;
+
+}} //ns
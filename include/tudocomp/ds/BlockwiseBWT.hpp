@@ -0,0 +1,248 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <tudocomp/def.hpp>
+#include <tudocomp/util.hpp>
+#include <tudocomp/util/View.hpp>
+#include <tudocomp/ds/IntVector.hpp>
+
+namespace tdc {
+namespace bwt {
+
+/**
+ * Compares suffixes of a text in O(v) time using the ranks of a
+ * difference cover sample (Kärkkäinen, Fast BWT in small space by
+ * blockwise suffix sorting, 2007).
+ *
+ * The sample consists of all suffixes starting at a position i with
+ * i mod v in the difference cover D. For any two positions i and j, there is
+ * a d < v such that both i+d and j+d are sampled, so the suffixes are
+ * ordered by their first d characters and the ranks of the sampled suffixes
+ * at i+d and j+d. The sample is sorted by prefix doubling and takes
+ * about |D|/v = 9/64 words per character.
+ */
+class DifferenceCoverSample {
+public:
+    static constexpr size_t V = 64;
+
+private:
+    static constexpr size_t COVER_SIZE = 9;
+
+    // a difference cover modulo V: every residue is a difference of two of its elements
+    static const uint8_t* cover() {
+        static const uint8_t D[COVER_SIZE] = { 0, 4, 27, 36, 39, 42, 44, 57, 58 };
+        return D;
+    }
+
+    View m_text;
+
+    // index of each residue in the cover, or COVER_SIZE if not in it
+    uint8_t m_cover_index[V];
+
+    // smallest d such that (i+d) mod V and (j+d) mod V are in the cover,
+    // for all residues i and j
+    uint8_t m_delta[V * V];
+
+    // rank of each sampled suffix among all sampled suffixes, starting at 1,
+    // or 0 for positions at or behind the end of the text
+    std::vector<len_compact_t> m_rank;
+
+    inline size_t sample_index(size_t i) const {
+        return (i / V) * COVER_SIZE + m_cover_index[i % V];
+    }
+
+    inline bool is_sampled(size_t i) const {
+        return m_cover_index[i % V] < COVER_SIZE;
+    }
+
+    inline len_compact_t rank_at(size_t i) const {
+        DCHECK(is_sampled(i));
+        return m_rank[sample_index(i)];
+    }
+
+    /// Compares the first `len` characters of the suffixes `i` and `j`,
+    /// where a suffix ending before is the smaller one.
+    inline int compare_prefix(size_t i, size_t j, size_t len) const {
+        const size_t n = m_text.size();
+        const size_t li = std::min(len, n - i);
+        const size_t lj = std::min(len, n - j);
+        const int c = std::memcmp(m_text.data() + i, m_text.data() + j, std::min(li, lj));
+        if(c != 0) return c;
+        return (li < lj) ? -1 : (li > lj);
+    }
+
+    inline void sort_sample() {
+        const size_t n = m_text.size();
+        m_rank.assign((n / V + 2) * COVER_SIZE, 0);
+
+        std::vector<len_compact_t> sa;
+        sa.reserve((n / V + 1) * COVER_SIZE);
+        for(size_t i = 0; i < n; i++) {
+            if(is_sampled(i)) sa.push_back(i);
+        }
+        if(sa.empty()) return;
+
+        // sort by the first V characters
+        std::sort(sa.begin(), sa.end(), [&](len_compact_t i, len_compact_t j) {
+            return compare_prefix(i, j, V) < 0;
+        });
+
+        // every group of suffixes with equal prefixes is ranked by the
+        // position of its first suffix in `sa`
+        bool unsorted = false;
+        m_rank[sample_index(sa[0])] = 1;
+        for(size_t k = 1; k < sa.size(); k++) {
+            if(compare_prefix(sa[k-1], sa[k], V) == 0) {
+                m_rank[sample_index(sa[k])] = m_rank[sample_index(sa[k-1])];
+                unsorted = true;
+            } else {
+                m_rank[sample_index(sa[k])] = k + 1;
+            }
+        }
+
+        // prefix doubling: refine each group by the ranks of the suffixes
+        // h characters behind, which are sampled as h is a multiple of V
+        for(size_t h = V; unsorted; h *= 2) {
+            unsorted = false;
+            auto second = [&](len_compact_t i) -> len_compact_t {
+                return (i + h < n) ? rank_at(i + h) : 0;
+            };
+
+            for(size_t l = 0; l < sa.size();) {
+                const len_compact_t rank = rank_at(sa[l]);
+                size_t r = l + 1;
+                while(r < sa.size() && rank_at(sa[r]) == rank) r++;
+
+                if(r - l > 1) {
+                    std::sort(sa.begin() + l, sa.begin() + r, [&](len_compact_t i, len_compact_t j) {
+                        return second(i) < second(j);
+                    });
+
+                    // the new ranks stay in the range of the group, so
+                    // they remain consistent with all other groups
+                    std::vector<len_compact_t> keys(r - l);
+                    for(size_t k = l; k < r; k++) keys[k - l] = second(sa[k]);
+                    for(size_t k = l + 1; k < r; k++) {
+                        if(keys[k - l] == keys[k - l - 1]) {
+                            m_rank[sample_index(sa[k])] = m_rank[sample_index(sa[k-1])];
+                            unsorted = true;
+                        } else {
+                            m_rank[sample_index(sa[k])] = k + 1;
+                        }
+                    }
+                }
+                l = r;
+            }
+        }
+    }
+
+public:
+    inline DifferenceCoverSample(View text): m_text(text) {
+        std::fill(m_cover_index, m_cover_index + V, uint8_t(COVER_SIZE));
+        for(size_t k = 0; k < COVER_SIZE; k++) {
+            m_cover_index[cover()[k]] = k;
+        }
+
+        for(size_t i = 0; i < V; i++) {
+            for(size_t j = 0; j < V; j++) {
+                size_t d = 0;
+                while(!is_sampled(i + d) || !is_sampled(j + d)) d++;
+                DCHECK_LT(d, size_t(V));
+                m_delta[i * V + j] = d;
+            }
+        }
+
+        sort_sample();
+    }
+
+    /// Returns whether the suffix `i` is lexicographically smaller than
+    /// the suffix `j`.
+    inline bool less(size_t i, size_t j) const {
+        const size_t d = m_delta[(i % V) * V + (j % V)];
+        const int c = compare_prefix(i, j, d);
+        if(c != 0) return c < 0;
+        return rank_at(i + d) < rank_at(j + d);
+    }
+};
+
+/**
+ * Computes the BWT of `text` without its suffix array by sorting the
+ * suffixes in `blocks` blocks (Kärkkäinen, 2007).
+ *
+ * Splitter suffixes are sampled from the text to partition all suffixes
+ * into blocks of about equal size. The blocks are sorted one after another
+ * using a \ref DifferenceCoverSample, and the BWT characters of each block
+ * are passed to `emit` as a \ref View. Besides the text, this needs about
+ * 0.6 bytes per character for the sample, half a byte per character for
+ * the block numbers and one word per suffix of a block.
+ */
+template<typename F>
+inline void blockwise_bwt(View text, size_t blocks, F emit) {
+    static constexpr size_t SPLITTER_OVERSAMPLING = 16;
+    static constexpr size_t MIN_BLOCK_SIZE = 1ull << 12;
+    static constexpr size_t CHUNK_SIZE = 1ull << 16;
+
+    const size_t n = text.size();
+    if(n == 0) return;
+
+    blocks = std::max(size_t(1), std::min({blocks, n / MIN_BLOCK_SIZE, size_t(256)}));
+
+    const DifferenceCoverSample dcs(text);
+    auto less = [&](len_compact_t i, len_compact_t j) { return dcs.less(i, j); };
+
+    // choose the splitters from a sorted random sample of suffixes
+    std::vector<len_compact_t> splitters;
+    if(blocks > 1) {
+        std::mt19937_64 rng(n);
+        std::uniform_int_distribution<size_t> dist(0, n - 1);
+
+        std::vector<len_compact_t> sample(blocks * SPLITTER_OVERSAMPLING);
+        for(auto& s : sample) s = dist(rng);
+        std::sort(sample.begin(), sample.end(), less);
+        sample.erase(std::unique(sample.begin(), sample.end()), sample.end());
+
+        for(size_t k = 1; k < blocks; k++) {
+            splitters.push_back(sample[k * sample.size() / blocks]);
+        }
+        splitters.erase(std::unique(splitters.begin(), splitters.end()), splitters.end());
+    }
+
+    // the block of suffix i contains all suffixes between the splitter
+    // before it (exclusive) and the splitter after it (inclusive)
+    DynamicIntVector block_of(n, 0, bits_for(splitters.size()));
+    if(!splitters.empty()) {
+        for(size_t i = 0; i < n; i++) {
+            block_of[i] = std::lower_bound(splitters.begin(), splitters.end(), len_compact_t(i), less)
+                - splitters.begin();
+        }
+    }
+
+    std::vector<uliteral_t> chunk;
+    chunk.reserve(std::min(n, CHUNK_SIZE));
+
+    std::vector<len_compact_t> block;
+    for(size_t b = 0; b <= splitters.size(); b++) {
+        block.clear();
+        for(size_t i = 0; i < n; i++) {
+            if(uint64_t(block_of[i]) == b) block.push_back(i);
+        }
+        std::sort(block.begin(), block.end(), less);
+
+        for(const len_compact_t i : block) {
+            chunk.push_back(text[(i == 0 ? n : i) - 1]);
+            if(chunk.size() == CHUNK_SIZE) {
+                emit(View(chunk.data(), chunk.size()));
+                chunk.clear();
+            }
+        }
+    }
+    if(!chunk.empty()) {
+        emit(View(chunk.data(), chunk.size()));
+    }
+}
+
+}} //ns
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <glog/logging.h>
+
+namespace tdc {
+
+/// \brief An array stored in a memory-mapped temporary file.
+///
+/// The file is unlinked right after its creation, so it disappears once the
+/// array is destroyed, even if the process terminates abnormally. Since the
+/// mapping is backed by the file rather than by swap space, the operating
+/// system can write pages back to disk and evict them under memory
+/// pressure, which allows for arrays that exceed the available RAM.
+///
+/// The array is accessed like a plain C array, random access patterns on
+/// arrays that do not fit into RAM will be slow.
+template<typename T>
+class FileArray {
+    static_assert(std::is_trivially_copyable<T>::value,
+        "FileArray elements must be trivially copyable");
+
+    std::string m_dir;
+    T*          m_data = nullptr;
+    size_t      m_size = 0;
+
+    inline void unmap() {
+        if(m_data) {
+            munmap(m_data, m_size * sizeof(T));
+            m_data = nullptr;
+        }
+    }
+
+public:
+    /// \brief The type of the array elements.
+    using value_type = T;
+
+    /// \brief Returns the directory to use for temporary files
+    ///        if none is specified.
+    ///
+    /// This is the value of the `TMPDIR` environment variable,
+    /// or `/tmp` if it is not set.
+    inline static std::string default_dir() {
+        const char* dir = std::getenv("TMPDIR");
+        return (dir && *dir) ? std::string(dir) : std::string("/tmp");
+    }
+
+    /// \brief Creates an empty array.
+    inline FileArray() {}
+
+    /// \brief Creates a zero-initialized array of `size` elements in a
+    ///        temporary file in directory `dir`.
+    inline FileArray(size_t size, const std::string& dir = "")
+        : m_dir(dir.empty() ? default_dir() : dir), m_size(size) {
+
+        if(m_size == 0) return;
+
+        std::string path_template = m_dir + "/tudocomp-XXXXXX";
+        std::vector<char> path(path_template.begin(), path_template.end());
+        path.push_back(0);
+
+        const int fd = mkstemp(path.data());
+        if(fd == -1) perror("FileArray error");
+        CHECK(fd != -1) << "Could not create temporary file in " << m_dir;
+        unlink(path.data());
+
+        const size_t bytes = m_size * sizeof(T);
+        const int ret = ftruncate(fd, bytes);
+        if(ret != 0) perror("FileArray error");
+        CHECK(ret == 0) << "Could not resize temporary file to " << bytes
+                        << " bytes";
+
+        void* ptr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                         MAP_SHARED, fd, 0);
+        if(ptr == MAP_FAILED) perror("FileArray error");
+        CHECK(ptr != MAP_FAILED) << "Could not map temporary file";
+
+        // the mapping keeps the file alive
+        close(fd);
+        m_data = (T*) ptr;
+    }
+
+    inline FileArray(const FileArray& other) = delete;
+    inline FileArray& operator=(const FileArray& other) = delete;
+
+    inline FileArray(FileArray&& other)
+        : m_dir(std::move(other.m_dir)),
+          m_data(other.m_data),
+          m_size(other.m_size) {
+
+        other.m_data = nullptr;
+        other.m_size = 0;
+    }
+
+    inline FileArray& operator=(FileArray&& other) {
+        if(this != &other) {
+            unmap();
+            m_dir = std::move(other.m_dir);
+            m_data = other.m_data;
+            m_size = other.m_size;
+            other.m_data = nullptr;
+            other.m_size = 0;
+        }
+        return *this;
+    }
+
+    inline ~FileArray() {
+        unmap();
+    }
+
+    /// \brief Creates a copy of the array in a new temporary file.
+    inline FileArray copy() const {
+        FileArray result(m_size, m_dir);
+        if(m_size > 0) std::memcpy(result.m_data, m_data, m_size * sizeof(T));
+        return result;
+    }
+
+    /// \brief Advises the operating system that the array is going to be
+    ///        accessed sequentially (`true`) or randomly (`false`).
+    inline void advise_sequential(bool sequential) const {
+        if(m_data) {
+            madvise(m_data, m_size * sizeof(T),
+                    sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+        }
+    }
+
+    inline T& operator[](size_t i) {
+        DCHECK_LT(i, m_size);
+        return m_data[i];
+    }
+
+    inline const T& operator[](size_t i) const {
+        DCHECK_LT(i, m_size);
+        return m_data[i];
+    }
+
+    inline T* data() { return m_data; }
+    inline const T* data() const { return m_data; }
+
+    inline T* begin() { return m_data; }
+    inline T* end() { return m_data + m_size; }
+    inline const T* begin() const { return m_data; }
+    inline const T* end() const { return m_data + m_size; }
+
+    /// \brief Returns the amount of elements.
+    inline size_t size() const { return m_size; }
+
+    /// \brief Returns the size of the backing file in bytes.
+    inline size_t file_size() const { return m_size * sizeof(T); }
+
+    /// \brief Returns the directory of the backing file.
+    inline const std::string& dir() const { return m_dir; }
+};
+
+/// \brief Base for data structures that use a \ref FileArray as a storage.
+///
+/// Counterpart of \ref ArrayDS for data structures that are stored on disk.
+template<typename T>
+class FileArrayDS: public FileArray<T> {
+protected:
+    inline void set_array(FileArray<T>&& array) {
+        (FileArray<T>&)(*this) = std::move(array);
+    }
+
+public:
+    /// \brief The data structure's data type.
+    using data_type = FileArray<T>;
+
+    inline FileArrayDS() {}
+
+    /// \brief Forces the data structure to relinquish its data storage.
+    ///
+    /// This is done by moving the ownership of the storage to the caller.
+    inline data_type relinquish() {
+        return std::move(static_cast<data_type&>(*this));
+    }
+
+    /// \brief File arrays are stored with a fixed width and are not
+    ///        compressed, so this does nothing.
+    inline void compress() {}
+};
+
+} //ns
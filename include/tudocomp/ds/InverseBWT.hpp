@@ -0,0 +1,234 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <tudocomp/def.hpp>
+#include <tudocomp/util.hpp>
+#include <tudocomp/util/View.hpp>
+#include <tudocomp/util/parallel.hpp>
+
+namespace tdc {
+namespace bwt {
+
+/**
+ * Answers rank queries on a BWT to compute its LF mapping without
+ * storing it.
+ *
+ * The BWT is divided into blocks. For each block, the occurrences of every
+ * character of the BWT before it are stored next to each other, relative
+ * to superblocks of 65536 characters, so a query reads one line of
+ * counters and scans at most half a block of the BWT from the closer
+ * block boundary. The block size grows with the amount of distinct
+ * characters, from 64 up to 512, so the counters take at most one byte
+ * per character instead of one word per character for the LF array.
+ */
+class OccurrenceRank {
+    static constexpr size_t SIGMA = ULITERAL_MAX + 1;
+    static constexpr size_t SUPER_BITS = 16;
+
+    View m_bwt;
+    size_t m_sigma;
+    size_t m_block_bits;
+
+    // the index of each character among the characters of the BWT
+    uint8_t m_index[SIGMA];
+
+    // the amount of characters smaller than each character
+    len_t m_C[SIGMA];
+
+    // occurrences of each character before each superblock
+    std::vector<len_compact_t> m_super;
+
+    // occurrences of each character before each block, relative to its superblock
+    std::vector<uint16_t> m_block;
+
+    /// Counts the occurrences of `c` in `text[0, len)`, eight characters
+    /// at a time.
+    static inline size_t count(const uliteral_t* text, size_t len, uliteral_t c) {
+        static constexpr uint64_t ONES = 0x0101010101010101ull;
+        static constexpr uint64_t LOW = 0x7F7F7F7F7F7F7F7Full;
+        const uint64_t pattern = ONES * c;
+
+        size_t occ = 0;
+        size_t k = 0;
+        for(; k + 8 <= len; k += 8) {
+            uint64_t w;
+            std::memcpy(&w, text + k, 8);
+            w ^= pattern;
+            // the highest bit of each byte is set iff the byte is zero
+            occ += __builtin_popcountll(~(((w & LOW) + LOW) | w | LOW));
+        }
+        for(; k < len; k++) {
+            occ += (text[k] == c);
+        }
+        return occ;
+    }
+
+    /// Returns the occurrences of `c` before block `b`.
+    inline len_t block_rank(uliteral_t c, size_t b) const {
+        const size_t x = m_index[literal2int(c)];
+        return m_super[((b << m_block_bits) >> SUPER_BITS) * m_sigma + x]
+            + m_block[b * m_sigma + x];
+    }
+
+public:
+    inline OccurrenceRank(View bwt): m_bwt(bwt) {
+        const size_t n = bwt.size();
+
+        std::vector<len_compact_t> occ(SIGMA, 0);
+        for(size_t i = 0; i < n; i++) {
+            ++occ[literal2int(bwt[i])];
+        }
+
+        std::vector<uliteral_t> chars;
+        len_t sum = 0;
+        for(size_t c = 0; c < SIGMA; c++) {
+            m_C[c] = sum;
+            sum += occ[c];
+            m_index[c] = chars.size();
+            if(occ[c] > 0) chars.push_back(c);
+        }
+        m_sigma = std::max(chars.size(), size_t(1));
+
+        // two bytes of counters per character of the alphabet
+        m_block_bits = std::min(size_t(9), std::max(size_t(6), size_t(bits_for(2 * m_sigma - 1))));
+        const size_t block_size = size_t(1) << m_block_bits;
+
+        m_super.resize(((n >> SUPER_BITS) + 1) * m_sigma);
+        m_block.resize(((n >> m_block_bits) + 1) * m_sigma);
+
+        std::fill(occ.begin(), occ.end(), 0);
+        for(size_t b = 0; b <= (n >> m_block_bits); b++) {
+            const size_t begin = b << m_block_bits;
+            const size_t s = begin >> SUPER_BITS;
+            for(size_t x = 0; x < chars.size(); x++) {
+                if((begin & ((size_t(1) << SUPER_BITS) - 1)) == 0) {
+                    m_super[s * m_sigma + x] = occ[chars[x]];
+                }
+                m_block[b * m_sigma + x] = occ[chars[x]] - m_super[s * m_sigma + x];
+            }
+            const size_t end = std::min(n, begin + block_size);
+            for(size_t i = begin; i < end; i++) {
+                ++occ[literal2int(bwt[i])];
+            }
+        }
+    }
+
+    /// Returns the occurrences of `c` in `bwt[0, i)`.
+    inline len_t rank(uliteral_t c, size_t i) const {
+        const size_t block_size = size_t(1) << m_block_bits;
+        const size_t b = i >> m_block_bits;
+        const size_t begin = b << m_block_bits;
+        const size_t end = begin + block_size;
+
+        if(i - begin <= block_size / 2 || end > m_bwt.size()) {
+            return block_rank(c, b) + count(m_bwt.data() + begin, i - begin, c);
+        } else {
+            return block_rank(c, b + 1) - count(m_bwt.data() + i, end - i, c);
+        }
+    }
+
+    /// Returns the row of the BWT matrix whose rotation is row `i`
+    /// rotated to the right by one character.
+    inline len_t LF(size_t i) const {
+        const uliteral_t c = m_bwt[i];
+        return m_C[literal2int(c)] + rank(c, i);
+    }
+};
+
+/**
+ * Decodes a BWT without an LF array and passes the text without its
+ * terminating sentinel to `emit`, in order and in chunks of \ref View.
+ *
+ * Every row whose index is a multiple of a fixed step is a starting point.
+ * From each of them, the LF mapping is followed until it reaches the next
+ * starting point, which yields the piece of the text in front of the
+ * starting point's suffix. These walks are independent of each other:
+ * every one of the `threads` threads (0 for one per hardware thread)
+ * advances several walks in lockstep, so the cache misses of their LF
+ * steps overlap. Finally, the pieces are chained in text order, starting
+ * from the suffix consisting of the sentinel in the first row.
+ *
+ * The BWT must contain the sentinel of the text as its only smallest
+ * character.
+ */
+template<typename F>
+inline void inverse_bwt(View bwt, size_t threads, F emit) {
+    static constexpr size_t STEP_BITS = 14;
+    static constexpr size_t STREAMS = 8;
+
+    const size_t n = bwt.size();
+    if(n <= 1) return;
+    if(threads == 0) threads = hardware_threads();
+
+    const OccurrenceRank occ(bwt);
+    auto is_start = [](len_t row) { return (row & ((1ull << STEP_BITS) - 1)) == 0; };
+
+    // the characters of each piece in reverse order, and the starting
+    // point its walk ends at
+    //
+    // The length of a piece is only known once its walk ends, so each one
+    // is reserved with the average length of the pieces.
+    const size_t pieces = ((n - 1) >> STEP_BITS) + 1;
+    std::vector<std::vector<uliteral_t>> text(pieces);
+    std::vector<len_compact_t> next(pieces);
+
+    const size_t groups = (pieces + STREAMS - 1) / STREAMS;
+    parallel_for(groups, threads, [&](size_t g) {
+        const size_t k0 = g * STREAMS;
+        const size_t streams = std::min(STREAMS, pieces - k0);
+
+        len_t row[STREAMS];
+        for(size_t s = 0; s < streams; s++) {
+            row[s] = (k0 + s) << STEP_BITS;
+            text[k0 + s].reserve((n + pieces - 1) / pieces);
+        }
+
+        for(size_t active = streams; active > 0;) {
+            for(size_t s = 0; s < streams; s++) {
+                if(row[s] == INDEX_MAX) continue;
+                text[k0 + s].push_back(bwt[row[s]]);
+                row[s] = occ.LF(row[s]);
+                if(is_start(row[s])) {
+                    next[k0 + s] = row[s] >> STEP_BITS;
+                    row[s] = INDEX_MAX;
+                    --active;
+                }
+            }
+        }
+    });
+
+    // the walks form a cycle through all pieces that starts at the end of
+    // the text, the suffix of the first row
+    std::vector<len_compact_t> order;
+    order.reserve(pieces);
+    size_t k = 0;
+    do {
+        order.push_back(k);
+        k = next[k];
+    } while(k != 0);
+    DCHECK_EQ(order.size(), pieces) << "the BWT is not a single cycle";
+
+    // the piece walked last ends with the sentinel, which precedes the
+    // text in its cycle
+    bool sentinel = true;
+    for(auto it = order.rbegin(); it != order.rend(); ++it) {
+        auto& piece = text[*it];
+        std::reverse(piece.begin(), piece.end());
+
+        View chunk(piece.data(), piece.size());
+        if(sentinel) {
+            chunk = chunk.substr(1);
+            sentinel = false;
+        }
+        if(!chunk.empty()) {
+            emit(chunk);
+        }
+        piece = std::vector<uliteral_t>();
+    }
+}
+
+}} //ns
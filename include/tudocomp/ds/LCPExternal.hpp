@@ -0,0 +1,61 @@
+#pragma once
+
+#include <tudocomp/ds/TextDSFlags.hpp>
+#include <tudocomp/ds/CompressMode.hpp>
+#include <tudocomp/ds/FileArray.hpp>
+
+#include <tudocomp_stat/StatPhase.hpp>
+
+namespace tdc {
+
+/// Constructs the LCP array from the PLCP array, storing it in a
+/// memory-mapped temporary file.
+///
+/// The suffix array and the LCP array are streamed, only the PLCP array is
+/// accessed randomly. The temporary file is created in the directory given
+/// by the `dir` option, which defaults to \ref FileArray::default_dir.
+class LCPExternal: public Algorithm, public FileArrayDS<len_t> {
+private:
+    len_t m_max;
+
+public:
+    inline static Meta meta() {
+        Meta m("lcp", "external",
+            "LCP array in a memory-mapped temporary file");
+        m.option("dir").dynamic(default_dir());
+        return m;
+    }
+
+    inline static ds::InputRestrictions restrictions() {
+        return ds::InputRestrictions {};
+    }
+
+    template<typename textds_t>
+    inline LCPExternal(Env&& env, textds_t& t, CompressMode cm)
+            : Algorithm(std::move(env)) {
+
+        // Construct Suffix Array and PLCP Array
+        auto& sa = t.require_sa(cm);
+        auto& plcp = t.require_plcp(cm);
+
+        const size_t n = t.size();
+
+        StatPhase::wrap("Construct LCP Array", [&]{
+            m_max = plcp.max_lcp();
+            set_array(FileArray<len_t>(n, this->env().option("dir").as_string()));
+
+            (*this)[0] = 0;
+            for(len_t i = 1; i < n; i++) {
+                (*this)[i] = plcp[sa[i]];
+            }
+
+            StatPhase::log("file_size", file_size());
+        });
+    }
+
+	inline len_t max_lcp() const {
+		return m_max;
+	}
+};
+
+} //ns
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <tudocomp/ds/TextDSFlags.hpp>
+#include <tudocomp/ds/CompressMode.hpp>
+#include <tudocomp/ds/FileArray.hpp>
+
+#include <tudocomp_stat/StatPhase.hpp>
+
+namespace tdc {
+
+/// Constructs the PLCP array using the Phi algorithm, storing it in a
+/// memory-mapped temporary file.
+///
+/// The Phi array is built in the same file and then overwritten by the
+/// PLCP array in a single sequential pass, so no further array is needed.
+/// Building the Phi array writes to it randomly, so like \ref SAExternal,
+/// it only performs well as long as the array fits into RAM.
+/// The `dir` option selects the directory for the temporary file, which
+/// defaults to \ref FileArray::default_dir.
+class PLCPExternal: public Algorithm, public FileArrayDS<len_t> {
+private:
+    len_t m_max;
+
+public:
+    inline static Meta meta() {
+        Meta m("plcp", "external",
+            "Phi algorithm on a memory-mapped temporary file");
+        m.option("dir").dynamic(default_dir());
+        return m;
+    }
+
+    inline static ds::InputRestrictions restrictions() {
+        return ds::InputRestrictions {};
+    }
+
+    template<typename textds_t>
+    inline PLCPExternal(Env&& env, textds_t& t, CompressMode cm)
+            : Algorithm(std::move(env)) {
+
+        // Construct Suffix Array
+        auto& sa = t.require_sa(cm);
+
+        const size_t n = t.size();
+
+        StatPhase::wrap("Construct Phi Array", [&]{
+            set_array(FileArray<len_t>(n, this->env().option("dir").as_string()));
+
+            for(len_t i = 1, prev = sa[0]; i < n; i++) {
+                (*this)[sa[i]] = prev;
+                prev = sa[i];
+            }
+            (*this)[sa[0]] = sa[n-1];
+        });
+
+        StatPhase::wrap("Construct PLCP Array", [&]{
+            // the Phi array is scanned sequentially
+            advise_sequential(true);
+
+            m_max = 0;
+            for(len_t i = 0, l = 0; i < n - 1; ++i) {
+                const len_t phii = (*this)[i];
+                while(t[i+l] == t[phii+l]) ++l;
+                m_max = std::max(m_max, l);
+                (*this)[i] = l;
+                if(l) --l;
+            }
+
+            advise_sequential(false);
+            StatPhase::log("file_size", file_size());
+        });
+    }
+
+	inline len_t max_lcp() const {
+		return m_max;
+	}
+};
+
+} //ns
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <tudocomp/ds/TextDSFlags.hpp>
+#include <tudocomp/ds/CompressMode.hpp>
+#include <tudocomp/ds/FileArray.hpp>
+#include <tudocomp/util/divsufsort.hpp>
+
+#include <tudocomp_stat/StatPhase.hpp>
+
+namespace tdc {
+
+/// Constructs the suffix array using divsufsort, storing it in a
+/// memory-mapped temporary file.
+///
+/// The array is kept in the page cache instead of the heap, so the kernel
+/// can write it back while it is not accessed. divsufsort accesses it
+/// randomly, however, so this is not an external memory construction: it
+/// only performs well as long as the array fits into RAM. The temporary
+/// file is created in the directory given by the `dir` option, which
+/// defaults to \ref FileArray::default_dir.
+class SAExternal: public Algorithm, public FileArrayDS<saidx_t> {
+public:
+    inline static Meta meta() {
+        Meta m("sa", "external",
+            "divsufsort on a memory-mapped temporary file");
+        m.option("dir").dynamic(default_dir());
+        return m;
+    }
+
+    inline static ds::InputRestrictions restrictions() {
+        return ds::InputRestrictions {
+            { 0 },
+            true
+        };
+    }
+
+    template<typename textds_t>
+    inline SAExternal(Env&& env, const textds_t& t, CompressMode)
+        : Algorithm(std::move(env)) {
+
+        StatPhase::wrap("Construct SA", [&]{
+            const size_t n = t.size();
+            set_array(FileArray<saidx_t>(n, this->env().option("dir").as_string()));
+
+            // Use divsufsort to construct directly on the mapping
+            saidx_t* sa = data();
+            divsufsort(t.text(), sa, n);
+
+            StatPhase::log("file_size", file_size());
+        });
+    }
+
+    /// Accesses the suffix array at position i.
+    ///
+    /// divsufsort needs signed entries, but all finished entries are
+    /// non-negative.
+    inline len_t operator[](size_t i) const {
+        return FileArrayDS<saidx_t>::operator[](i);
+    }
+};
+
+} //ns
@@ -0,0 +1,273 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <tudocomp/ds/TextDSFlags.hpp>
+#include <tudocomp/ds/CompressMode.hpp>
+#include <tudocomp/ds/ArrayDS.hpp>
+#include <tudocomp/util/parallel.hpp>
+#include <tudocomp/Algorithm.hpp>
+
+#include <tudocomp_stat/StatPhase.hpp>
+
+namespace tdc {
+
+/// Constructs the suffix array in parallel using prefix doubling.
+///
+/// The suffixes are first distributed into buckets by their first two
+/// characters, which are then sorted by the first eight characters. After
+/// that, groups of suffixes sharing the same prefix are refined by
+/// doubling the length of the compared prefix in each round, using the rank
+/// of the suffix following that prefix as key
+/// (see Larsson and Sadakane, "Faster suffix sorting").
+///
+/// All groups are sorted independently and thus get distributed over the
+/// threads, groups that are too large for this are sorted with a parallel
+/// sort instead.
+///
+/// While sorting, the suffix array and the ranks take one \ref len_t per
+/// character each, the group boundaries one byte per character, plus the
+/// list of groups that are not sorted yet. The ranks are freed before the
+/// suffix array is copied into the output array, so that step needs one
+/// \ref len_t and one output entry per character.
+class SAParallel: public Algorithm, public ArrayDS {
+    using group_t = std::pair<len_t, len_t>;
+
+    /// Amount of initial buckets, one for each prefix of two characters.
+    static constexpr size_t BUCKETS = size_t(1) << 16;
+
+    size_t m_threads;
+    std::vector<size_t> m_thread_time;
+
+    /// Sorts each group of `sa` by the keys of its suffixes,
+    /// and marks the first suffix of each run of equal keys in `head`.
+    template<typename key_f>
+    inline void sort_groups(std::vector<len_t>& sa,
+                            std::vector<uint8_t>& head,
+                            const std::vector<group_t>& groups,
+                            key_f key)
+    {
+        using clk = std::chrono::steady_clock;
+
+        auto comp = [&](len_t a, len_t b) {
+            return key(a) < key(b);
+        };
+
+        auto mark_heads = [&](const group_t& g) {
+            head[g.first] = 1;
+            for(size_t j = g.first + 1; j < g.second; ++j) {
+                head[j] = key(sa[j]) != key(sa[j - 1]);
+            }
+        };
+
+        // groups that exceed the share of a single thread
+        const size_t large_size = std::max(size_t(1) << 16,
+                                           sa.size() / m_threads);
+
+        parallel_for_with_thread(groups.size(), m_threads,
+            [&](size_t i, size_t t) {
+                auto& g = groups[i];
+                if(g.second - g.first >= large_size) return;
+
+                auto start = clk::now();
+                std::sort(sa.begin() + g.first, sa.begin() + g.second, comp);
+                mark_heads(g);
+                m_thread_time[t] += std::chrono::duration_cast<
+                    std::chrono::milliseconds>(clk::now() - start).count();
+            });
+
+        for(auto& g : groups) {
+            if(g.second - g.first >= large_size) {
+                parallel_sort(sa.begin() + g.first, sa.begin() + g.second,
+                              comp, m_threads);
+                mark_heads(g);
+            }
+        }
+    }
+
+    /// Assigns the new ranks after sort_groups and returns the groups of
+    /// suffixes that are not yet distinguished.
+    inline std::vector<group_t> split_groups(const std::vector<len_t>& sa,
+                                             std::vector<len_t>& rank,
+                                             const std::vector<uint8_t>& head,
+                                             const std::vector<group_t>& groups)
+    {
+        std::vector<std::vector<group_t>> split(m_threads);
+
+        parallel_for_with_thread(groups.size(), m_threads,
+            [&](size_t i, size_t t) {
+                auto& g = groups[i];
+
+                size_t run_start = g.first;
+                for(size_t j = g.first; j < g.second; ++j) {
+                    if(head[j]) run_start = j;
+                    rank[sa[j]] = run_start;
+
+                    if(j + 1 == g.second || head[j + 1]) {
+                        if(j + 1 - run_start > 1) {
+                            split[t].emplace_back(run_start, j + 1);
+                        }
+                    }
+                }
+            });
+
+        std::vector<group_t> result;
+        for(auto& s : split) {
+            result.insert(result.end(), s.begin(), s.end());
+        }
+        return result;
+    }
+
+    template<typename text_t>
+    inline void construct(const text_t& text,
+                          const size_t n,
+                          std::vector<len_t>& sa,
+                          std::vector<len_t>& rank)
+    {
+        std::vector<uint8_t> head(n);
+        std::vector<group_t> groups;
+
+        // Distribute suffixes into buckets by their first two characters
+        StatPhase::wrap("Bucket Sort", [&]{
+            auto bucket = [&](size_t i) -> size_t {
+                return (size_t(text[i]) << 8) |
+                    ((i + 1 < n) ? size_t(text[i + 1]) : 0);
+            };
+
+            const size_t chunks = m_threads;
+            std::vector<std::vector<size_t>> counts(
+                chunks, std::vector<size_t>(BUCKETS, 0));
+
+            parallel_for(chunks, m_threads, [&](size_t c) {
+                auto& count = counts[c];
+                for(size_t i = n * c / chunks; i < n * (c + 1) / chunks; ++i) {
+                    ++count[bucket(i)];
+                }
+            });
+
+            // turn counts into starting positions per chunk and bucket
+            size_t sum = 0;
+            for(size_t b = 0; b < BUCKETS; ++b) {
+                const size_t bucket_start = sum;
+                for(size_t c = 0; c < chunks; ++c) {
+                    const size_t count = counts[c][b];
+                    counts[c][b] = sum;
+                    sum += count;
+                }
+                if(sum > bucket_start) {
+                    groups.emplace_back(bucket_start, sum);
+                }
+            }
+
+            parallel_for(chunks, m_threads, [&](size_t c) {
+                auto& pos = counts[c];
+                for(size_t i = n * c / chunks; i < n * (c + 1) / chunks; ++i) {
+                    sa[pos[bucket(i)]++] = i;
+                }
+            });
+        });
+
+        // Sort buckets by the first eight characters
+        StatPhase::wrap("Initial Sort", [&]{
+            auto key = [&](size_t i) -> uint64_t {
+                uint64_t k = 0;
+                for(size_t j = i; j < i + 8; ++j) {
+                    k = (k << 8) | ((j < n) ? uint64_t(text[j]) : 0);
+                }
+                return k;
+            };
+
+            sort_groups(sa, head, groups, key);
+            groups = split_groups(sa, rank, head, groups);
+        });
+
+        // Prefix doubling
+        StatPhase::wrap("Prefix Doubling", [&]{
+            size_t rounds = 0;
+            for(size_t h = 8; !groups.empty(); h *= 2) {
+                // Suffixes that are not distinguished by their first h
+                // characters are longer than h due to the unique sentinel,
+                // the check only guards against texts without one.
+                auto key = [&](size_t i) -> size_t {
+                    return (i + h < n) ? size_t(rank[i + h]) + 1 : 0;
+                };
+
+                sort_groups(sa, head, groups, key);
+                groups = split_groups(sa, rank, head, groups);
+                ++rounds;
+            }
+            StatPhase::log("rounds", rounds);
+        });
+    }
+
+public:
+    inline static Meta meta() {
+        Meta m("sa", "parallel", "Parallel prefix doubling");
+        m.option("threads").dynamic(0);
+        return m;
+    }
+
+    inline static ds::InputRestrictions restrictions() {
+        return ds::InputRestrictions {
+            { 0 },
+            true
+        };
+    }
+
+    template<typename textds_t>
+    inline SAParallel(Env&& env, const textds_t& t, CompressMode cm)
+        : Algorithm(std::move(env)) {
+
+        m_threads = this->env().option("threads").as_integer();
+        if(m_threads == 0) m_threads = hardware_threads();
+        m_thread_time.assign(m_threads, 0);
+
+        StatPhase::wrap("Construct SA", [&]{
+            const size_t n = t.size();
+            std::vector<len_t> sa(n);
+
+            {
+                // freed before the output array is allocated
+                std::vector<len_t> rank(n);
+                construct(t.text(), n, sa, rank);
+            }
+
+            // Allocate
+            const size_t w = bits_for(n);
+            set_array(iv_t(n, 0, (cm == CompressMode::compressed) ? w : INDEX_FAST_BITS));
+            for(size_t i = 0; i < n; ++i) {
+                (*this)[i] = sa[i];
+            }
+
+            StatPhase::log("threads", m_threads);
+            for(size_t i = 0; i < m_threads; ++i) {
+                StatPhase::log(("thread_" + std::to_string(i) + "_ms").c_str(),
+                               m_thread_time[i]);
+            }
+            StatPhase::log("bit_width", size_t(width()));
+            StatPhase::log("size", bit_size() / 8);
+        });
+
+        if(cm == CompressMode::compressed || cm == CompressMode::delayed) {
+            compress();
+        }
+    }
+
+    void compress() {
+        debug_check_array_is_initialized();
+
+        StatPhase::wrap("Compress SA", [this]{
+            width(bits_for(size()));
+            shrink_to_fit();
+
+            StatPhase::log("bit_width", size_t(width()));
+            StatPhase::log("size", bit_size() / 8);
+        });
+    }
+};
+
+} //ns
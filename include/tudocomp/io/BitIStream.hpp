@@ -1,8 +1,10 @@
 #pragma once
 
+#include <algorithm>
 #include <climits>
 #include <cstdint>
 #include <iostream>
+#include <vector>
 #include <tudocomp/util.hpp>
 
 namespace tdc {
@@ -11,73 +13,97 @@ namespace io {
 /// \brief Wrapper for input streams that provides bitwise reading
 /// functionality.
 ///
-/// The current byte in the underlying input stream is buffered and processed
-/// bitwise using another cursor.
+/// The underlying input stream is read in chunks, from which up to 64 bits
+/// at a time are loaded into a buffer word that is processed bitwise.
+///
+/// The last two bytes of the input are only loaded once the end of the
+/// stream is known, because they tell how many bits of them are valid (see
+/// \ref BitOStream). Reading beyond the valid bits yields zero bits.
 class BitIStream {
-    InputStream m_stream;
+    static constexpr size_t CHUNK_SIZE = 4096;
 
-    uint8_t m_current = 0;
-    uint8_t m_next = 0;
+    InputStream m_stream;
 
-    bool m_is_final = false;
-    uint8_t m_final_bits = 0;
+    std::vector<uint8_t> m_chunk; // read from the stream, but not loaded
+    size_t m_chunk_pos = 0;
+    bool m_stream_end = false;
 
-    uint8_t m_cursor = 0;
+    uint64_t m_bits_loaded = 0; // amount of bits loaded into the buffer
+    uint64_t m_bits_valid = UINT64_MAX; // known once m_stream_end is set
 
-    inline void read_next() {
-        const uint8_t MSB = 7;
+    /// The buffered bits, MSB first. Only the highest m_bits bits are
+    /// valid, the others are zero.
+    uint64_t m_buffer = 0;
+    size_t m_bits = 0;
 
-        m_current = m_next;
-        m_cursor = MSB;
+    inline void read_chunk() {
+        m_chunk.erase(m_chunk.begin(), m_chunk.begin() + m_chunk_pos);
+        m_chunk_pos = 0;
 
-        char c;
-        if(m_stream.get(c)) {
-            m_next = c;
+        const size_t old_size = m_chunk.size();
+        m_chunk.resize(old_size + CHUNK_SIZE);
+        m_stream.read((char*) m_chunk.data() + old_size, CHUNK_SIZE);
+        const size_t read = m_stream.gcount();
+        m_chunk.resize(old_size + read);
 
-            if(m_stream.get(c)) {
-                /*DLOG(INFO) << "read_next: ...";*/
+        if(read < CHUNK_SIZE) {
+            m_stream_end = true;
 
-                // stream still going
-                m_stream.unget();
+            // determine the amount of valid bits from the final byte
+            const size_t n = m_chunk.size();
+            if(n == 0) {
+                m_bits_valid = m_bits_loaded;
             } else {
-                // stream over after next, do some checks
-                m_final_bits = c;
-                m_final_bits &= 0x7;
-                if(m_final_bits >= 6) {
-                    // special case - already final
-                    m_is_final = true;
-                    m_next = 0;
-                    /*DLOG(INFO) << "read_next: EOF*" <<
-                        ", m_final_bits := " << size_t(m_final_bits);*/
-                }
+                const uint8_t set = m_chunk[n - 1] & 0x7;
+                const size_t full = (set >= 6) ? n - std::min(n, size_t(2))
+                                               : n - 1;
+                m_bits_valid = m_bits_loaded + 8 * full + set;
             }
-        } else {
-            m_is_final = true;
-            m_final_bits = m_current & 0x7;
+        }
+    }
+
+    /// Loads as many bytes as possible into the buffer.
+    inline void refill() {
+        if(!m_stream_end && m_chunk.size() - m_chunk_pos < 2 + 8) {
+            read_chunk();
+        }
 
-            m_next = 0;
+        const size_t avail = m_chunk.size() - m_chunk_pos;
+        const size_t limit = m_stream_end ? avail : avail - 2;
+        const size_t bytes = std::min(limit, (64 - m_bits) / 8);
 
-            /*DLOG(INFO) << "read_next: EOF" <<
-                ", m_final_bits := " << size_t(m_final_bits);*/
+        const uint8_t* p = m_chunk.data() + m_chunk_pos;
+        for(size_t i = 0; i < bytes; i++) {
+            m_buffer |= uint64_t(p[i]) << (56 - m_bits);
+            m_bits += 8;
+        }
+        m_chunk_pos += bytes;
+        m_bits_loaded += 8 * bytes;
+
+        if(m_bits_loaded > m_bits_valid) {
+            // discard the bits of the final byte(s) that are not valid
+            const size_t excess = std::min(uint64_t(m_bits),
+                                           m_bits_loaded - m_bits_valid);
+            m_bits -= excess;
+            m_bits_loaded -= excess;
+            m_buffer &= m_bits ? ~(UINT64_MAX >> m_bits) : 0;
+            m_bits_valid = m_bits_loaded;
         }
     }
 
+    /// Removes the `n` (1 to 64) highest bits from the buffer.
+    inline void skip(size_t n) {
+        m_buffer = (m_buffer << (n - 1)) << 1;
+        m_bits = (n < m_bits) ? m_bits - n : 0;
+    }
+
 public:
     /// \brief Constructs a bitwise input stream.
     ///
     /// \param input The underlying input stream.
     inline BitIStream(InputStream&& input) : m_stream(std::move(input)) {
-        char c;
-        if(m_stream.get(c)) {
-            m_is_final = false;
-            m_next = c;
-
-            read_next();
-        } else {
-            //empty stream
-            m_is_final = true;
-            m_final_bits = 0;
-        }
+        m_chunk.reserve(CHUNK_SIZE + 2 + 8);
+        refill();
     }
 
     /// \brief Constructs a bitwise input stream.
@@ -89,47 +115,84 @@ public:
     /// \brief Reads the next single bit from the input.
     /// \return 1 if the next bit is set, 0 otherwise.
     inline uint8_t read_bit() {
-        /*DLOG(INFO) <<"read_bit: " <<
-                "m_is_final = " << m_is_final <<
-                ", m_final_bits = " << size_t(m_final_bits) <<
-                ", m_cursor = " << size_t(m_cursor);*/
-
-        if(!eof()) {
-            uint8_t bit = (m_current >> m_cursor) & 1;
-            if(m_cursor) {
-                --m_cursor;
-            } else {
-                read_next();
-            }
+        if(m_bits == 0) refill();
 
-            return bit;
-        } else {
-            return 0; //EOF
-        }
+        const uint8_t bit = m_buffer >> 63;
+        skip(1);
+        return bit;
     }
 
     /// \brief Reads the integer value of the next \c amount bits in MSB first
     ///        order.
     /// \tparam The integer type to read.
     /// \param amount The bit width of the integer to read. By default, this
-    ///               equals the bit width of type \c T.
+    ///               equals the bit width of type \c T. At most 64 bits can
+    ///               be read at once.
     /// \return The integer value of the next \c amount bits in MSB first
     ///         order.
     template<class T>
     inline T read_int(size_t amount = sizeof(T) * CHAR_BIT) {
-        T value = 0;
-        for(size_t i = 0; i < amount; i++) {
-            value <<= 1;
-            value |= read_bit();
+        DCHECK_LE(amount, 64U);
+        if(amount == 0) return T(0);
+
+        if(amount > 56) {
+            // the buffer may not be able to hold that many bits at once
+            const uint64_t high = read_int<uint64_t>(amount - 32);
+            const uint64_t low = read_int<uint64_t>(32);
+            return T((high << 32) | low);
         }
-        return value;
+
+        if(m_bits < amount) refill();
+
+        const uint64_t value = m_buffer >> (64 - amount);
+        skip(amount);
+        return T(value);
+    }
+
+    /// \brief Returns the integer value of the next \c amount bits in MSB
+    ///        first order without advancing the input.
+    ///
+    /// Bits beyond the end of the input are zero. At most 56 bits can be
+    /// peeked at once.
+    template<class T>
+    inline T peek_int(size_t amount) {
+        DCHECK_GT(amount, 0U);
+        DCHECK_LE(amount, 56U);
+
+        if(m_bits < amount) refill();
+        return T(m_buffer >> (64 - amount));
     }
 
+    /// \brief Advances the input by \c amount bits that have been looked at
+    ///        using \ref peek_int.
+    inline void skip_bits(size_t amount) {
+        DCHECK_GT(amount, 0U);
+        DCHECK_LE(amount, 56U);
+
+        skip(amount);
+    }
+
+    /// \brief Reads a unary code, i.e., counts the zero bits before the next
+    ///        one bit.
     template<typename value_t>
     inline value_t read_unary() {
         value_t v = 0;
-        while(!read_bit()) ++v;
-        return v;
+        while(true) {
+            if(m_bits == 0) {
+                refill();
+                if(m_bits == 0) return v; // EOF
+            }
+
+            if(m_buffer) {
+                const size_t zeros = __builtin_clzll(m_buffer);
+                v += zeros;
+                skip(zeros + 1);
+                return v;
+            } else {
+                v += m_bits;
+                m_bits = 0;
+            }
+        }
     }
 
     template<typename value_t>
@@ -187,9 +250,10 @@ public:
         return T(value);
     }
 
-    /// TODO document
-    inline bool eof() const {
-        return m_is_final && m_cursor <= (7 - m_final_bits);
+    /// \brief Tests whether all valid bits of the input have been read.
+    inline bool eof() {
+        if(m_bits == 0) refill();
+        return m_bits == 0;
     }
 };
 
@@ -12,28 +12,23 @@ namespace io {
 /// \brief Wrapper for output streams that provides bitwise writing
 /// functionality.
 ///
-/// Bits are written into a buffer byte, which is written to the output when
-/// it is either filled or when a flush is explicitly requested.
+/// Bits are collected in a 64-bit buffer, which is written to the output as
+/// a whole word when it is filled. Remaining bits are written when the
+/// stream is destroyed.
 class BitOStream {
     OutputStream m_stream;
 
-    bool m_dirty;
-    uint8_t m_next;
-    int m_cursor;
+    /// The buffered bits, the least recently written bit being the most
+    /// significant one. Only the lowest m_bits bits are valid.
+    uint64_t m_buffer = 0;
+    size_t m_bits = 0;
 
-    inline void reset() {
-        const int MSB = 7;
-
-        m_next = 0;
-        m_cursor = MSB;
-        m_dirty = false;
-    }
-
-    inline void write_next() {
-        if (m_dirty) {
-            m_stream.put(char(m_next));
-            reset();
+    inline void write_word(uint64_t w) {
+        char bytes[8];
+        for(size_t i = 0; i < 8; i++) {
+            bytes[i] = char(w >> (56 - 8 * i));
         }
+        m_stream.write(bytes, 8);
     }
 
 public:
@@ -41,7 +36,6 @@ public:
     ///
     /// \param output The underlying output stream.
     inline BitOStream(OutputStream&& output) : m_stream(std::move(output)) {
-        reset();
     }
 
     /// \brief Constructs a bitwise output stream.
@@ -51,39 +45,42 @@ public:
     }
 
     ~BitOStream() {
-        char set = 7 - m_cursor;
-        if(m_cursor >= 2) {
-            m_next |= set;
-        } else {
-            write_next();
-            m_next = set;
+        // write complete bytes
+        while(m_bits >= 8) {
+            m_bits -= 8;
+            m_stream.put(char(m_buffer >> m_bits));
         }
 
-        m_dirty = true;
-        write_next();
+        // the amount of bits used in the final byte is stored in its three
+        // lowest bits, or in an extra byte if they are used
+        const uint8_t set = m_bits;
+        const uint8_t last = uint8_t(m_buffer << (8 - m_bits));
+        if(set < 6) {
+            m_stream.put(char(last | set));
+        } else {
+            m_stream.put(char(last));
+            m_stream.put(char(set));
+        }
     }
 
     /// \brief Returns the output position indicator of the underlying stream,
-    ///        which should equal the amount of bytes written to it.
+    ///        plus the amount of complete bytes that are still buffered.
     ///
-    /// Note that this value does not include bits that have not yet been
-    /// flushed.
+    /// Note that this value does not include bits that do not yet
+    /// fill a byte.
     ///
-    /// \return the output position indicator of the underlying stream
+    /// \return the amount of bytes written
     inline auto tellp() -> decltype(m_stream.tellp()) {
-        return m_stream.tellp();
+        return m_stream.tellp() + std::streamoff(m_bits / 8);
     }
 
     /// \brief Writes a single bit to the output.
     /// \param set The bit value (0 or 1).
     inline void write_bit(bool set) {
-        if (set) {
-            m_next |= (1 << m_cursor);
-        }
-
-        m_dirty = true;
-        if (--m_cursor < 0) {
-            write_next();
+        m_buffer = (m_buffer << 1) | uint64_t(set);
+        if(++m_bits == 64) {
+            write_word(m_buffer);
+            m_bits = 0;
         }
     }
 
@@ -93,21 +90,35 @@ public:
     /// \tparam The type of integer to write.
     /// \param value The integer to write.
     /// \param bits The amount of low bits of the value to write. By default,
-    ///             this equals the bit width of type \c T.
+    ///             this equals the bit width of type \c T. At most 64 bits
+    ///             can be written at once.
     template<class T>
     inline void write_int(T value, size_t bits = sizeof(T) * CHAR_BIT) {
-        for (int i = bits - 1; i >= 0; i--) {
-            write_bit((value & T(T(1) << i)) != T(0));
+        DCHECK_LE(bits, 64U);
+        if(bits == 0) return;
+
+        const uint64_t v = uint64_t(value) & (uint64_t(-1) >> (64 - bits));
+        const size_t free = 64 - m_bits;
+        if(bits < free) {
+            // bits above m_bits in the buffer are shifted out eventually
+            m_buffer = (m_buffer << bits) | v;
+            m_bits += bits;
+        } else {
+            const size_t rest = bits - free;
+            write_word(((m_buffer << (free - 1)) << 1) | (v >> rest));
+            m_buffer = v;
+            m_bits = rest;
         }
     }
 
     template<typename value_t>
     inline void write_unary(value_t v) {
-        while(v--) {
-            write_bit(0);
+        uint64_t n = v;
+        while(n >= 64) {
+            write_int(uint64_t(0), 64);
+            n -= 64;
         }
-
-        write_bit(1);
+        write_int(uint64_t(1), n + 1);
     }
 
     template<typename value_t>
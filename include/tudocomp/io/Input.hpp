@@ -47,6 +47,10 @@ namespace tdc {namespace io {
             size_t m_from = 0;
             size_t m_to = npos;
             mutable size_t m_escaped_size_cache = npos;
+
+            // for unbuffered stream inputs: whether the stream has been
+            // handed out to be read directly
+            std::shared_ptr<bool> m_stream_consumed;
         protected:
             inline void set_escaped_size(size_t size) const {
                 m_escaped_size_cache = size;
@@ -64,7 +68,9 @@ namespace tdc {namespace io {
                 m_escaped_size_cache = npos;
             }
         public:
-            inline Variant(const InputSource& src): m_source(src) {}
+            inline Variant(const InputSource& src, bool unbuffered = false):
+                m_source(src),
+                m_stream_consumed(unbuffered ? std::make_shared<bool>(false) : nullptr) {}
 
             inline const InputAllocHandle& alloc() const {
                 return m_handle;
@@ -99,6 +105,32 @@ namespace tdc {namespace io {
                 return m_source;
             }
 
+            inline void check_not_consumed() const {
+                CHECK(!m_stream_consumed || !*m_stream_consumed)
+                    << "Attempt to access an unbuffered stream `Input` "
+                    << "after its stream has been read.";
+            }
+
+            /// Returns whether the stream of an unbuffered input can be
+            /// read directly.
+            ///
+            /// This is the case if the whole input is requested and
+            /// no buffered copy of it has been created yet.
+            inline bool is_unbuffered_stream() const {
+                if (!m_stream_consumed) return false;
+                check_not_consumed();
+
+                return m_from == 0 && to_unknown() && !alloc().contains(m_source);
+            }
+
+            /// Returns whether the stream of an unbuffered input can be
+            /// read directly, and marks it as consumed if so.
+            inline bool take_unbuffered_stream() const {
+                if (!is_unbuffered_stream()) return false;
+                *m_stream_consumed = true;
+                return true;
+            }
+
             /// Creates a slice of this Variant.
             /// The arguments `from` and `to` are relative to the current size()
             inline std::shared_ptr<Variant> slice(size_t from, size_t to) const;
@@ -158,6 +190,22 @@ namespace tdc {namespace io {
         Input(std::istream& stream):
             m_data(std::make_shared<Variant>(InputSource(&stream))) {}
 
+        /// \brief Constructs an input reading from a stream that is not
+        /// buffered in memory if possible.
+        ///
+        /// The first call of \ref as_stream for the whole input reads the
+        /// stream directly, as long as no view or size of the input has been
+        /// requested before. Afterwards, the input can not be accessed
+        /// anymore. Accesses before that buffer the stream in memory like
+        /// an input constructed from the stream does.
+        ///
+        /// \param stream The input stream.
+        static Input unbuffered(std::istream& stream) {
+            Input input;
+            input.m_data = std::make_shared<Variant>(InputSource(&stream), true);
+            return input;
+        }
+
         /// \brief Move assignment operator.
         Input& operator=(Input&& other) {
             m_data = std::move(other.m_data);
@@ -234,6 +282,19 @@ namespace tdc {namespace io {
             return m_data->size();
         }
 
+        /// \brief Yields the total amount of characters in the input if it
+        /// can be determined without buffering the input, or `npos`
+        /// otherwise.
+        ///
+        /// This is meant for algorithms that only use the size to reserve
+        /// memory: unlike \ref size, it keeps an unbuffered stream input
+        /// readable directly by \ref as_stream.
+        ///
+        /// \return The total amount of characters in the input, or `npos`.
+        inline size_t size_hint() const {
+            return m_data->is_unbuffered_stream() ? npos : m_data->size();
+        }
+
         /// \cond INTERNAL
         /// Slice constructor.
         ///
@@ -350,6 +350,16 @@ namespace tdc {namespace io {
             }
         }
 
+        /// Returns whether an allocation for the source exists.
+        inline bool contains(const InputSource& src) const {
+            for (auto& eptr : *m_ptr) {
+                if (eptr && eptr->source() == src) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
         inline InputAllocHandle(): m_ptr(std::make_shared<InputAlloc>()) {}
         inline InputAllocHandle(std::weak_ptr<InputAlloc> weak) {
             DCHECK(!weak.expired());
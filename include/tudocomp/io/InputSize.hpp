@@ -46,6 +46,7 @@ namespace tdc {namespace io {
 
         } else if (source().is_stream()) {
             if(escaped_size_unknown()) {
+                check_not_consumed();
                 auto p = alloc().find_or_construct(
                     InputSource(source().stream()), from(), to(), restrictions());
                 set_escaped_size(p->view().size());
@@ -69,6 +69,20 @@ namespace tdc {namespace io {
             inline File() = delete;
         };
 
+        class Stream: public InputStreamInternal::Variant {
+            std::istream* m_stream;
+
+            friend class InputStreamInternal;
+        public:
+            inline Stream(std::istream* stream):
+                m_stream(stream)
+            {}
+
+            inline std::istream& stream() override {
+                return *m_stream;
+            }
+        };
+
         std::unique_ptr<InputStreamInternal::Variant> m_variant;
         std::unique_ptr<RestrictedIStreamBuf> m_restricted_istream;
 
@@ -100,6 +114,17 @@ namespace tdc {namespace io {
                 );
             }
         }
+        inline InputStreamInternal(InputStreamInternal::Stream&& s,
+                                   const InputRestrictions& restrictions):
+            m_variant(std::make_unique<InputStreamInternal::Stream>(std::move(s)))
+        {
+            if (!restrictions.has_no_restrictions()) {
+                m_restricted_istream = std::make_unique<RestrictedIStreamBuf>(
+                    m_variant->stream(),
+                    restrictions
+                );
+            }
+        }
         inline InputStreamInternal(InputStreamInternal&& s):
             m_variant(std::move(s.m_variant)),
             m_restricted_istream(std::move(s.m_restricted_istream)) {}
@@ -147,6 +172,17 @@ namespace tdc {namespace io {
         // Change in such a way that restricting stream is applied
         // for both file and memory
 
+        if (take_unbuffered_stream()) {
+            return InputStream {
+                InputStreamInternal {
+                    InputStream::Stream {
+                        source().stream()
+                    },
+                    restrictions()
+                }
+            };
+        }
+
         if (source().is_file()) {
             DCHECK(to_unknown())
                 << "TODO: Can not yet slice the trailing end of a stream";
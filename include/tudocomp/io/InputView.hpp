@@ -46,6 +46,7 @@ namespace tdc {namespace io {
     };
 
     inline InputView Input::Variant::as_view() const {
+        check_not_consumed();
         return InputView {
             alloc().find_or_construct(source(), from(), to(), restrictions())
         };
@@ -53,6 +53,101 @@ namespace tdc {namespace io {
 
         State    m_state = State::Unmapped;
         Mode     m_mode  = Mode::Read;
+        bool     m_file_backed = false;
+
+        // Bytes accounted for in the memory statistics, and the range of
+        // a private file mapping that has been written to
+        size_t   m_charged = 0;
+        size_t   m_written_begin = 0;
+        size_t   m_written_end = 0;
+
+        inline void charge(size_t bytes) {
+            IF_STATS({
+                malloc_callback::on_free(m_charged);
+                malloc_callback::on_alloc(bytes);
+            })
+            m_charged = bytes;
+        }
+
+        /// Maps `file_part_size` bytes of the file `fd` starting at `offset`
+        /// to the start of this mapping, without copying.
+        ///
+        /// Returns `false` if the file could not be mapped, in which case
+        /// this instance remains unmapped.
+        inline bool map_file(int fd,
+                             size_t file_part_size,
+                             size_t offset,
+                             bool needs_to_overallocate)
+        {
+            int mmap_prot;
+            int mmap_flags;
+            State state;
+
+            if (m_mode == Mode::ReadWrite) {
+                mmap_prot = PROT_READ | PROT_WRITE;
+                mmap_flags = MAP_PRIVATE;
+                state = State::Private;
+            } else {
+                mmap_prot = PROT_READ;
+                mmap_flags = MAP_SHARED;
+                state = State::Shared;
+            }
+
+            void* ptr;
+            if (!needs_to_overallocate) {
+                // Map file directly into memory
+                ptr = mmap(NULL,
+                           adj_size(m_size),
+                           mmap_prot,
+                           mmap_flags,
+                           fd,
+                           offset);
+                if (ptr == MAP_FAILED) {
+                    return false;
+                }
+            } else {
+                // Reserve the full size as zero-initialized anonymous memory,
+                // and place the file mapping over its prefix.
+                //
+                // Accessing pages of a file mapping that lie completely
+                // behind the end of the file is an error, so this ensures
+                // those are covered by the anonymous mapping instead.
+                ptr = mmap(NULL,
+                           adj_size(m_size),
+                           mmap_prot,
+                           MAP_PRIVATE | MAP_ANONYMOUS,
+                           -1,
+                           0);
+                if (ptr == MAP_FAILED) {
+                    return false;
+                }
+
+                if (file_part_size > 0) {
+                    void* file_ptr = mmap(ptr,
+                                          file_part_size,
+                                          mmap_prot,
+                                          mmap_flags | MAP_FIXED,
+                                          fd,
+                                          offset);
+                    if (file_ptr == MAP_FAILED) {
+                        munmap(ptr, adj_size(m_size));
+                        return false;
+                    }
+                    DCHECK(file_ptr == ptr);
+                }
+
+                // The anonymous part is private memory in any case
+                state = State::Private;
+            }
+
+            // Private pages are only copied once they are written to, see
+            // mark_written
+            m_ptr = (uint8_t*) ptr;
+            m_state = state;
+            m_file_backed = true;
+
+            return true;
+        }
 
     public:
         inline static bool is_offset_valid(size_t offset) {
@@ -74,8 +169,19 @@ namespace tdc {namespace io {
         /// Create a memory map of length `size` with a prefix initalized by
         /// the contents of a file from offset `offset`.
         ///
-        /// If `size` does not exceed the original files size, and mode
-        /// is set to read-only, this does a direct shared file mapping.
+        /// The file is mapped directly into memory, without copying it:
+        /// In read-only mode this is a shared file mapping, in read-write
+        /// mode a private copy-on-write file mapping.
+        ///
+        /// If `size` exceeds the original files size, the file mapping
+        /// is placed at the start of an anonymous mapping of the full size,
+        /// such that the part behind the end of the file reads as zero bytes.
+        /// In read-write mode, only pages that actually get written to
+        /// (for example the last page when adding a null terminator)
+        /// will get copied.
+        ///
+        /// Should the direct mapping fail, the file gets copied into
+        /// an anonymous mapping instead.
         inline MMap(const std::string& path,
              Mode mode,
              size_t size,
@@ -91,55 +197,17 @@ namespace tdc {namespace io {
             bool needs_to_overallocate =
                 (offset + m_size) > file_size;
 
+            // Number of bytes of the mapping that are backed by the file
+            size_t file_part_size = 0;
+            if (offset < file_size) {
+                file_part_size = std::min(m_size, file_size - offset);
+            }
+
             // Open file for memory map
             auto fd = open(path.c_str(), O_RDONLY);
             CHECK(fd != -1) << "Error at opening file";
 
-            int mmap_prot;
-            int mmap_flags;
-
-            bool try_next = false;
-
-            if (!needs_to_overallocate) {
-                // Map file directly into memory
-
-                State state;
-
-                if (m_mode == Mode::ReadWrite) {
-                    mmap_prot = PROT_READ | PROT_WRITE;
-                    mmap_flags = MAP_PRIVATE;
-                    state = State::Private;
-                } else {
-                    mmap_prot = PROT_READ;
-                    mmap_flags = MAP_SHARED;
-                    state = State::Shared;
-                }
-
-                void* ptr = mmap(NULL,
-                                adj_size(m_size),
-                                mmap_prot,
-                                mmap_flags,
-                                fd,
-                                offset);
-                //check_mmap_error(ptr, "mapping file into memory");
-                if (false && ptr != MAP_FAILED) {
-                    m_ptr = (uint8_t*) ptr;
-                    m_state = state;
-                    IF_STATS(if (m_state == State::Private) {
-                        malloc_callback::on_alloc(adj_size(m_size));
-                    })
-                } else {
-                    //LOG(INFO) << "Mapping file into memory failed, falling"
-                    //          << " back to copying into a anonymous map";
-                    try_next = true;
-                }
-            }
-
-            if (try_next || needs_to_overallocate) {
-                if (try_next) {
-                    //std::cout << "I get used\n";
-                }
-
+            if (!map_file(fd, file_part_size, offset, needs_to_overallocate)) {
                 // Allocate memory and copy file into it
 
                 *this = MMap(m_size);
@@ -156,14 +224,14 @@ namespace tdc {namespace io {
                 // copy data
                 {
                     auto ptr = m_ptr;
-                    auto size = file_size - offset;
+                    auto size = file_part_size;
 
                     while (size > 0) {
                         auto ret = read(fd, ptr, size);
                         if (ret == -1) {
                             perror("Reading fd into mapped memory");
                         }
-                        CHECK(ret >= 0);
+                        CHECK(ret > 0);
                         size -= ret;
                         ptr += ret;
                     }
@@ -194,9 +262,7 @@ namespace tdc {namespace io {
             m_ptr = (uint8_t*) ptr;
 
             m_state = State::Private;
-            IF_STATS(if (m_state == State::Private) {
-                malloc_callback::on_alloc(adj_size(m_size));
-            })
+            charge(adj_size(m_size));
         }
 
         /// Changes the size of this mapping.
@@ -205,18 +271,16 @@ namespace tdc {namespace io {
         inline void remap(size_t new_size) {
             DCHECK(m_mode == Mode::ReadWrite);
             DCHECK(m_state == State::Private);
+            DCHECK(!m_file_backed) << "Can not remap a file mapping";
 
             // On Linux, use mremap to expand memory in place
             #ifndef __MACH__
 
             auto p = mremap(m_ptr, adj_size(m_size), adj_size(new_size), MREMAP_MAYMOVE);
             check_mmap_error(p, "remapping memory");
-            IF_STATS(if (m_state == State::Private) {
-                malloc_callback::on_free(adj_size(m_size));
-                malloc_callback::on_alloc(adj_size(new_size));
-                // TODO ^ handle lazy initialization better by not seemingly
-                // allocating everything
-            })
+            // TODO: handle lazy initialization better by not seemingly
+            // allocating everything
+            charge(adj_size(new_size));
 
             m_ptr = (uint8_t*) p;
             m_size =  new_size;
@@ -232,6 +296,34 @@ namespace tdc {namespace io {
             #endif
         }
 
+        /// Accounts for a write to the bytes `[from, to)` of a private file
+        /// mapping in the memory statistics.
+        ///
+        /// The pages of such a mapping only take up memory once they get
+        /// copied on the first write, so they are not accounted for on
+        /// creation. Writes are expected to form a single range, anything
+        /// between them is accounted for as well.
+        inline void mark_written(size_t from, size_t to) {
+            DCHECK_LE(from, to);
+            DCHECK_LE(to, m_size);
+            if (!m_file_backed || m_state != State::Private || from == to) {
+                return;
+            }
+
+            if (m_written_begin == m_written_end) {
+                m_written_begin = from;
+                m_written_end = to;
+            } else {
+                m_written_begin = std::min(m_written_begin, from);
+                m_written_end = std::max(m_written_end, to);
+            }
+
+            const size_t ps = pagesize();
+            const size_t first_page = m_written_begin / ps;
+            const size_t last_page = (m_written_end + ps - 1) / ps;
+            charge((last_page - first_page) * ps);
+        }
+
         View view() const {
             return View(m_ptr, m_size);
         }
@@ -253,8 +345,16 @@ namespace tdc {namespace io {
 
             m_state = other.m_state;
             m_mode  = other.m_mode;
+            m_file_backed = other.m_file_backed;
+            m_charged = other.m_charged;
+            m_written_begin = other.m_written_begin;
+            m_written_end = other.m_written_end;
 
             other.m_state = State::Unmapped;
+            other.m_file_backed = false;
+            other.m_charged = 0;
+            other.m_written_begin = 0;
+            other.m_written_end = 0;
             other.m_ptr = (uint8_t*) EMPTY;
             other.m_size = 0;
         }
@@ -274,9 +374,7 @@ namespace tdc {namespace io {
 
                 int rc = munmap(m_ptr, adj_size(m_size));
                 CHECK(rc == 0) << "Error at unmapping";
-                IF_STATS(if (m_state == State::Private) {
-                    malloc_callback::on_free(adj_size(m_size));
-                })
+                IF_STATS(malloc_callback::on_free(m_charged);)
             }
         }
     };
@@ -19,7 +19,9 @@ namespace io {
     ///
     /// This class serves as a generic abstraction over different output sinks:
     /// memory, files or streams. Output is generally done in a stream, ie it
-    /// is written to the sink character by character.
+    /// is written to the sink character by character. Data that is
+    /// available in one piece should be written as a whole, see
+    /// \ref OutputStream::write.
     class Output {
         class Variant {
             InputRestrictions m_restrictions;
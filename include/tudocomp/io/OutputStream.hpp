@@ -8,6 +8,7 @@
 #include <utility>
 #include <vector>
 
+#include <tudocomp/util/View.hpp>
 #include <tudocomp/io/BackInsertStream.hpp>
 #include<tudocomp/io/RestrictedIOStream.hpp>
 
@@ -64,7 +65,12 @@ namespace io {
             inline Stream() = delete;
         };
         class File: public Variant {
+            /// The size of the file stream's buffer, so bulk output
+            /// reaches the file in few large writes.
+            static constexpr size_t BUFFER_SIZE = 1ull << 20;
+
             std::string m_path;
+            std::unique_ptr<char[]> m_buffer;
             std::unique_ptr<std::ofstream> m_stream;
 
         public:
@@ -72,11 +78,16 @@ namespace io {
 
             inline File(std::string&& path, bool overwrite = false) {
                 m_path = path;
+                m_buffer = std::make_unique<char[]>(BUFFER_SIZE);
+                m_stream = std::make_unique<std::ofstream>();
+
+                // the buffer has to be set before the file is opened
+                m_stream->rdbuf()->pubsetbuf(m_buffer.get(), BUFFER_SIZE);
                 if (overwrite) {
-                    m_stream = std::make_unique<std::ofstream>(m_path,
+                    m_stream->open(m_path,
                         std::ios::out | std::ios::binary);
                 } else {
-                    m_stream = std::make_unique<std::ofstream>(m_path,
+                    m_stream->open(m_path,
                         std::ios::out | std::ios::binary | std::ios::app);
                 }
                 if (!*m_stream) {
@@ -86,6 +97,7 @@ namespace io {
 
             inline File(File&& other):
                 m_path(std::move(other.m_path)),
+                m_buffer(std::move(other.m_buffer)),
                 m_stream(std::move(other.m_stream)) {}
 
             inline std::ostream& stream() override {
@@ -152,6 +164,10 @@ namespace io {
         }
 
         inline std::streampos tellp() {
+            if (m_restricted_ostream) {
+                // pass on data buffered by the adapter
+                m_restricted_ostream->pubsync();
+            }
             return m_variant->tellp();
         }
     };
@@ -180,6 +196,16 @@ namespace io {
         inline std::streampos tellp() {
             return OutputStreamInternal::tellp();
         }
+
+        using std::ostream::write;
+
+        /// \brief Writes a span of bytes to the output at once.
+        ///
+        /// This is considerably faster than writing the bytes one by one.
+        inline OutputStream& write(View bytes) {
+            std::ostream::write((const char*) bytes.data(), bytes.size());
+            return *this;
+        }
     };
 
     inline OutputStream Output::Memory::as_stream() const {
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <streambuf>
+#include <vector>
+
+namespace tdc {namespace io {
+    /// \brief A bounded buffer passing a byte stream from one writing thread
+    /// to one reading thread.
+    ///
+    /// The bytes are transferred in blocks. The writer blocks while the pipe
+    /// holds `capacity` blocks and the reader blocks while it is empty, so
+    /// the memory in flight between both threads is bounded.
+    class Pipe {
+        std::mutex m_mutex;
+        std::condition_variable m_not_full;
+        std::condition_variable m_not_empty;
+
+        std::deque<std::vector<char>> m_blocks;
+        size_t m_capacity;
+
+        bool m_writer_closed = false;
+        bool m_reader_closed = false;
+    public:
+        /// The default size of the blocks written by a \ref PipeOStreamBuf.
+        static constexpr size_t BLOCK_SIZE = 1ull << 16;
+
+        /// \brief Constructs an empty pipe.
+        ///
+        /// \param capacity The maximum amount of blocks held by the pipe.
+        inline Pipe(size_t capacity = 4): m_capacity(std::max(size_t(1), capacity)) {}
+
+        /// \brief Appends a block, waiting while the pipe is full.
+        ///
+        /// \return `false` if the reader closed the pipe, in which case
+        ///         the block is discarded.
+        inline bool push(std::vector<char>&& block) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_not_full.wait(lock, [&]{
+                return m_blocks.size() < m_capacity || m_reader_closed;
+            });
+            if(m_reader_closed) return false;
+
+            m_blocks.push_back(std::move(block));
+            m_not_empty.notify_one();
+            return true;
+        }
+
+        /// \brief Removes the next block, waiting while the pipe is empty.
+        ///
+        /// \return `false` if the writer closed the pipe and all of its
+        ///         blocks have been removed.
+        inline bool pop(std::vector<char>& block) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_not_empty.wait(lock, [&]{
+                return !m_blocks.empty() || m_writer_closed;
+            });
+            if(m_blocks.empty()) return false;
+
+            block = std::move(m_blocks.front());
+            m_blocks.pop_front();
+            m_not_full.notify_one();
+            return true;
+        }
+
+        /// \brief Signals the reader that no more blocks will be written.
+        inline void close_writer() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_writer_closed = true;
+            m_not_empty.notify_all();
+        }
+
+        /// \brief Signals the writer that no more blocks will be read.
+        ///
+        /// Remaining and further blocks are discarded, so the writer does
+        /// not wait forever if the reader stops early.
+        inline void close_reader() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_reader_closed = true;
+            m_blocks.clear();
+            m_not_full.notify_all();
+        }
+    };
+
+    /// \brief A stream buffer writing into a \ref Pipe.
+    ///
+    /// The written bytes are collected into blocks that are passed to the
+    /// pipe once they are full, when the buffer is flushed or when it is
+    /// closed.
+    class PipeOStreamBuf: public std::streambuf {
+        Pipe* m_pipe;
+        size_t m_block_size;
+        std::vector<char> m_block;
+        bool m_closed = false;
+
+        inline void reset_block() {
+            m_block.resize(m_block_size);
+            setp(m_block.data(), m_block.data() + m_block.size());
+        }
+
+        inline bool flush_block() {
+            const size_t n = pptr() - pbase();
+            if(n == 0) return true;
+
+            m_block.resize(n);
+            const bool ok = m_pipe->push(std::move(m_block));
+            m_block = std::vector<char>();
+            reset_block();
+            return ok;
+        }
+
+    protected:
+        virtual int overflow(int ch) override {
+            if(!flush_block()) {
+                return traits_type::eof();
+            }
+            if(ch != traits_type::eof()) {
+                *pptr() = traits_type::to_char_type(ch);
+                pbump(1);
+            }
+            return traits_type::not_eof(ch);
+        }
+
+        virtual int sync() override {
+            return flush_block() ? 0 : -1;
+        }
+
+    public:
+        /// \brief Constructs a stream buffer writing into the pipe.
+        inline PipeOStreamBuf(Pipe& pipe, size_t block_size = Pipe::BLOCK_SIZE):
+            m_pipe(&pipe),
+            m_block_size(std::max(size_t(1), block_size))
+        {
+            reset_block();
+        }
+
+        /// \brief Passes the remaining bytes to the pipe and closes it
+        /// for writing.
+        inline void close() {
+            if(m_closed) return;
+            flush_block();
+            m_pipe->close_writer();
+            m_closed = true;
+        }
+
+        inline ~PipeOStreamBuf() {
+            close();
+        }
+    };
+
+    /// \brief A stream buffer reading from a \ref Pipe.
+    class PipeIStreamBuf: public std::streambuf {
+        Pipe* m_pipe;
+        std::vector<char> m_block;
+
+    protected:
+        virtual int underflow() override {
+            while(m_pipe->pop(m_block)) {
+                if(!m_block.empty()) {
+                    setg(m_block.data(), m_block.data(), m_block.data() + m_block.size());
+                    return traits_type::to_int_type(*gptr());
+                }
+            }
+            return traits_type::eof();
+        }
+
+    public:
+        /// \brief Constructs a stream buffer reading from the pipe.
+        inline PipeIStreamBuf(Pipe& pipe): m_pipe(&pipe) {
+        }
+    };
+}}
@@ -39,8 +39,15 @@ namespace tdc {namespace io {
         // [   [offset|from_______to]     ]
         size_t m_mmap_page_offset = 0;
 
+        /// Escapes `[read_begin, read_end)` backwards into the range ending
+        /// at `write_end`, and returns the start of the written range.
+        ///
+        /// Without `do_copy`, the escaping happens in place. Once the write
+        /// position reaches the read position, no byte in front of it needs
+        /// escaping anymore, so these bytes are not touched and the pages
+        /// holding them do not get dirtied.
         template<typename I, typename J>
-        inline void escape_with_iters(I read_begin, I read_end, J write_end, bool do_copy = false) {
+        inline J escape_with_iters(I read_begin, I read_end, J write_end, bool do_copy = false) {
             if (!m_restrictions.has_no_escape_restrictions()) {
                 FastEscapeMap fast_escape_map;
                 uint8_t escape_byte;
@@ -52,6 +59,8 @@ namespace tdc {namespace io {
                 }
 
                 while(read_begin != read_end) {
+                    if (!do_copy && read_end == write_end) break;
+
                     --read_end;
                     --write_end;
 
@@ -71,6 +80,7 @@ namespace tdc {namespace io {
                     *write_end = *read_end;
                 }
             }
+            return write_end;
         }
 
         // NB: The len argument would be redundant, but exists because
@@ -173,14 +183,19 @@ namespace tdc {namespace io {
 
                     size_t noff = m_restrictions.null_terminate()? 1 : 0;
 
-                    uint8_t* begin_file_data = m_map.view().begin() + m_mmap_page_offset;
+                    uint8_t* begin_map       = m_map.view().begin();
+                    uint8_t* begin_file_data = begin_map            + m_mmap_page_offset;
                     uint8_t* end_file_data   = begin_file_data      + unrestricted_size;
                     uint8_t* end_data        = end_file_data        + extra_size - noff;
-                    escape_with_iters(begin_file_data, end_file_data, end_data);
-                    if (m_restrictions.null_terminate()) {
-                        // ensure the last valid byte is actually 0 if using null termination
+                    uint8_t* begin_written   = escape_with_iters(begin_file_data, end_file_data, end_data);
+                    uint8_t* end_written     = end_data;
+                    if (m_restrictions.null_terminate() && *end_data != 0) {
+                        // ensure the last valid byte is actually 0 if using null termination,
+                        // behind the end of the file it already is
                         *end_data = 0;
+                        end_written = end_data + 1;
                     }
+                    m_map.mark_written(begin_written - begin_map, end_written - begin_map);
                     m_restricted_data = m_map.view().slice(m_mmap_page_offset);
                 }
             } else if (m_source.is_stream()) {
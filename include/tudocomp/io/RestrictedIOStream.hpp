@@ -1,22 +1,31 @@
 #pragma once
 
+#include <vector>
+
 #include<tudocomp/io/EscapeMap.hpp>
 
 namespace tdc {namespace io {
-    // TODO: Make these adapters use buffers to reduce
-    // virtual call overhead.
-
     /// Adapter class over a `std::ostream` that
     /// reverse the escaping and null termination
     /// of data written to it according
     /// to the provided input restrictions.
+    ///
+    /// Written data is collected in a put area and unescaped in bulk into
+    /// an output buffer, which is written to the underlying stream in
+    /// chunks to avoid a virtual call per character.
     class RestrictedOStreamBuf: public std::streambuf {
     private:
+        /// The size of the put area and of the output buffer.
+        static constexpr size_t BUFFER_SIZE = 1ull << 16;
+
         std::ostream* m_stream;
         FastUnescapeMap m_fast_unescape_map;
         bool m_saw_escape = false;
         bool m_saw_null = false;
 
+        std::vector<char> m_put; // escaped data written to this adapter
+        std::vector<char> m_out; // unescaped data not yet written to m_stream
+
         /*
          Null termination logic is going to be a bit funky:
          If null termination is enabled, this adapter will
@@ -25,15 +34,21 @@ namespace tdc {namespace io {
          This way, the very last null will be ellided but no earlier ones.
          */
 
-        inline void internal_flush() {
-            // Nothing to do here, as any state needs further input to react
+        inline void flush_out() {
+            if (!m_out.empty()) {
+                m_stream->write(m_out.data(), m_out.size());
+                m_out.clear();
+            }
+        }
+
+        inline void put_internal(uint8_t d) {
+            m_out.push_back(char(d));
+            if (m_out.size() >= BUFFER_SIZE) {
+                flush_out();
+            }
         }
 
         inline void push_unescape(uint8_t c) {
-            auto put_internal = [&](uint8_t d){
-                m_stream->put(char(d));
-            };
-
             if (m_saw_escape) {
                 m_saw_escape = false;
                 if (m_saw_null) {
@@ -60,17 +75,35 @@ namespace tdc {namespace io {
             }
         }
 
+        inline void unescape(const char* s, size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                push_unescape(uint8_t(s[i]));
+            }
+        }
+
+        /// Unescapes the contents of the put area and resets it.
+        inline void drain() {
+            unescape(pbase(), pptr() - pbase());
+            setp(m_put.data(), m_put.data() + m_put.size());
+        }
+
     public:
         inline RestrictedOStreamBuf(std::ostream& stream,
                                     const InputRestrictions& restrictions):
             m_stream(&stream),
-            m_fast_unescape_map(EscapeMap(restrictions)) {}
+            m_fast_unescape_map(EscapeMap(restrictions)),
+            m_put(BUFFER_SIZE) {
+            m_out.reserve(BUFFER_SIZE);
+            setp(m_put.data(), m_put.data() + m_put.size());
+        }
 
         inline RestrictedOStreamBuf() = delete;
         inline RestrictedOStreamBuf(const RestrictedOStreamBuf& other) = delete;
         inline RestrictedOStreamBuf(RestrictedOStreamBuf&& other) = delete;
 
         inline virtual ~RestrictedOStreamBuf() {
+            drain();
+            flush_out();
             if (m_fast_unescape_map.null_terminate()) {
                 DCHECK(m_saw_null) << "Text to be unescaped did not end with a 0";
             }
@@ -78,13 +111,26 @@ namespace tdc {namespace io {
 
     protected:
         inline virtual int overflow(int ch) override {
-            if (ch == traits_type::eof()) {
-                internal_flush();
-            } else {
+            drain();
+            if (ch != traits_type::eof()) {
                 push_unescape(traits_type::to_char_type(ch));
             }
+            return traits_type::not_eof(ch);
+        }
+
+        inline virtual std::streamsize xsputn(const char* s,
+                                              std::streamsize n) override {
+            drain();
+            unescape(s, n);
+            return n;
+        }
 
-            return ch;
+        // Any state that needs further input to react is kept back.
+        inline virtual int sync() override {
+            drain();
+            flush_out();
+            m_stream->flush();
+            return m_stream->good() ? 0 : -1;
         }
     };
 
@@ -31,6 +31,11 @@ protected:
         }
     }
 
+    virtual std::streamsize xsputn(const char* s, std::streamsize n) override {
+        m_vec->insert(m_vec->end(), s, s + n);
+        return n;
+    }
+
     virtual int underflow() override {
         return EOF;
     }
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tdc {
+
+/// Returns the number of threads to use if none is specified explicitly.
+///
+/// This is the number of hardware threads, or 1 if it can not be determined.
+inline size_t hardware_threads() {
+    size_t n = std::thread::hardware_concurrency();
+    return std::max(size_t(1), n);
+}
+
+/// Calls `f(i, t)` for every `i` in `[0, n)`, distributed over `threads`
+/// threads, where `t` in `[0, threads)` identifies the calling thread.
+///
+/// This allows `f` to accumulate results in per-thread storage without
+/// synchronization. Indices are handed out dynamically, so uneven amounts of
+/// work per index get balanced between the threads. The calling thread
+/// participates in the work as thread 0 and the function returns once all
+/// indices have been processed.
+///
+/// If any call of `f` throws, remaining indices are skipped and the first
+/// exception is rethrown in the calling thread.
+///
+/// Note that statistics phases are tracked per thread, so allocations done
+/// inside of `f` by a worker thread do not show up in the current phase.
+template<typename F>
+inline void parallel_for_with_thread(size_t n, size_t threads, F f) {
+    threads = std::max(size_t(1), std::min(threads, n));
+
+    if (threads == 1) {
+        for (size_t i = 0; i < n; i++) {
+            f(i, size_t(0));
+        }
+        return;
+    }
+
+    std::atomic<size_t> next { 0 };
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    auto work = [&](size_t t) {
+        size_t i;
+        while ((i = next.fetch_add(1)) < n) {
+            try {
+                f(i, t);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                next = n;
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (size_t t = 1; t < threads; t++) {
+        workers.emplace_back(work, t);
+    }
+    work(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+/// Calls `f(i)` for every `i` in `[0, n)`, distributed over `threads` threads.
+///
+/// See \ref parallel_for_with_thread.
+template<typename F>
+inline void parallel_for(size_t n, size_t threads, F f) {
+    parallel_for_with_thread(n, threads, [&](size_t i, size_t) { f(i); });
+}
+
+/// Sorts `[first, last)` using `threads` threads.
+///
+/// The range is split into one chunk per thread, which are sorted
+/// independently and then merged pairwise in parallel.
+template<typename It, typename Comp>
+inline void parallel_sort(It first, It last, Comp comp, size_t threads) {
+    const size_t n = last - first;
+    const size_t chunks = std::max(size_t(1), std::min(threads, n));
+
+    std::vector<size_t> bounds(chunks + 1);
+    for (size_t c = 0; c <= chunks; c++) {
+        bounds[c] = n * c / chunks;
+    }
+
+    parallel_for(chunks, threads, [&](size_t c) {
+        std::sort(first + bounds[c], first + bounds[c + 1], comp);
+    });
+
+    for (size_t step = 1; step < chunks; step *= 2) {
+        const size_t merges = (chunks + 2 * step - 1) / (2 * step);
+        parallel_for(merges, threads, [&](size_t m) {
+            const size_t l = 2 * step * m;
+            const size_t mid = std::min(l + step, chunks);
+            const size_t r = std::min(l + 2 * step, chunks);
+            std::inplace_merge(first + bounds[l],
+                               first + bounds[mid],
+                               first + bounds[r],
+                               comp);
+        });
+    }
+}
+
+}
@@ -36,6 +36,44 @@ inline void write_vbyte(std::ostream& os, int_t v) {
 	} while(v > 0);
 }
 
+/// The maximum amount of bytes of a 64-bit integer in the vbyte-encoding.
+constexpr size_t VBYTE_MAX_BYTES = 10;
+
+/**
+ * Stores an integer as a bunch of bytes at `out`, which needs room for
+ * \ref VBYTE_MAX_BYTES bytes. Returns the amount of bytes written.
+ */
+template<class int_t>
+inline size_t write_vbyte(uint8_t* out, int_t v) {
+	size_t i = 0;
+	do {
+		uint8_t byte = v & 0x7F;
+		v >>= 7;
+		if(v > 0) byte |= 0x80;
+		out[i++] = byte;
+	} while(v > 0);
+	return i;
+}
+
+/**
+ * Reads an integer stored as a bunch of bytes from `[p, end)` and advances
+ * `p` behind it. Returns false, leaving `p` unchanged, if the bytes end
+ * before the integer or it is longer than \ref VBYTE_MAX_BYTES bytes.
+ */
+template<class int_t>
+inline bool read_vbyte(const uint8_t*& p, const uint8_t* end, int_t& v) {
+	int_t ret = 0;
+	for(size_t i = 0; i < VBYTE_MAX_BYTES && p + i < end; ++i) {
+		const uint8_t byte = p[i];
+		ret |= int_t(byte & 0x7F) << (7 * i);
+		if(!(byte & 0x80)) {
+			p += i + 1;
+			v = ret;
+			return true;
+		}
+	}
+	return false;
+}
 
 }//ns
 
@@ -0,0 +1,229 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <tudocomp/Compressor.hpp>
+#include <tudocomp/io.hpp>
+#include <tudocomp/util/parallel.hpp>
+#include <tudocomp/util/vbyte.hpp>
+
+/// \cond INTERNAL
+namespace tdc_driver {
+
+using namespace tdc;
+
+/// Header that precedes the algorithm header of a block container.
+const std::string BLOCK_CONTAINER_HEADER = "#blocks";
+
+/// Creates a fresh compressor instance for a single block.
+using CompressorFactory = std::function<std::unique_ptr<Compressor>()>;
+
+/// Splits an input into independently compressed blocks.
+///
+/// The blocks are (de-)compressed in parallel, each by its own compressor
+/// instance. The container is laid out as follows:
+///
+/// \code
+/// [block 0]...[block k-1] [index] [index size]
+/// \endcode
+///
+/// The index contains the amount of blocks followed by the uncompressed and
+/// compressed size of each block, all encoded as vbytes. The index size is
+/// stored as a little-endian 64-bit integer at the very end, so the
+/// container can be written to non-seekable outputs.
+///
+/// To bound the memory needed for buffering, blocks are processed in
+/// batches of one block per thread.
+class BlockContainer {
+    static constexpr size_t TRAILER_SIZE = sizeof(uint64_t);
+
+    CompressorFactory m_factory;
+    io::InputRestrictions m_restrictions;
+    size_t m_threads;
+
+    struct Block {
+        size_t size;
+        size_t compressed_size;
+    };
+
+    inline static void write_index(std::ostream& os,
+                                   const std::vector<Block>& blocks) {
+        std::vector<uint8_t> index;
+        {
+            Output index_output(index);
+            auto index_stream = index_output.as_stream();
+
+            write_vbyte(index_stream, blocks.size());
+            for (auto& block : blocks) {
+                write_vbyte(index_stream, block.size);
+                write_vbyte(index_stream, block.compressed_size);
+            }
+        }
+
+        os.write((const char*) index.data(), index.size());
+
+        uint64_t index_size = index.size();
+        for (size_t i = 0; i < TRAILER_SIZE; i++) {
+            os.put(char(uint8_t(index_size >> (8 * i))));
+        }
+    }
+
+    inline static std::vector<Block> read_index(View container,
+                                                size_t& data_size) {
+        if (container.size() < TRAILER_SIZE) {
+            throw std::runtime_error("Block container is missing its index");
+        }
+
+        uint64_t index_size = 0;
+        auto trailer = container.slice(container.size() - TRAILER_SIZE);
+        for (size_t i = 0; i < TRAILER_SIZE; i++) {
+            index_size |= uint64_t(trailer[i]) << (8 * i);
+        }
+
+        if (index_size > container.size() - TRAILER_SIZE) {
+            throw std::runtime_error("Block container has an invalid index");
+        }
+
+        data_size = container.size() - TRAILER_SIZE - index_size;
+
+        Input index_input(container.slice(data_size, data_size + index_size));
+        auto index_stream = index_input.as_stream();
+
+        std::vector<Block> blocks(read_vbyte<size_t>(index_stream));
+        size_t compressed_total = 0;
+        for (auto& block : blocks) {
+            block.size = read_vbyte<size_t>(index_stream);
+            block.compressed_size = read_vbyte<size_t>(index_stream);
+            compressed_total += block.compressed_size;
+        }
+
+        if (compressed_total != data_size) {
+            throw std::runtime_error("Block container has an invalid index");
+        }
+
+        return blocks;
+    }
+
+public:
+    /// Creates a container that uses compressors created by `factory`,
+    /// which need the given input restrictions.
+    ///
+    /// If `threads` is zero, all hardware threads are used.
+    inline BlockContainer(CompressorFactory factory,
+                          io::InputRestrictions restrictions,
+                          size_t threads):
+        m_factory(factory),
+        m_restrictions(restrictions),
+        m_threads(threads == 0 ? hardware_threads() : threads) {}
+
+    /// Compresses `input` in blocks of `block_size` bytes into `output`.
+    inline void compress(Input& input, Output& output, size_t block_size) {
+        DCHECK_GT(block_size, 0);
+
+        auto view = input.as_view();
+        const size_t n = view.size();
+        const size_t num_blocks = (n + block_size - 1) / block_size;
+
+        auto os = output.as_stream();
+
+        std::vector<Block> blocks;
+        std::vector<std::vector<uint8_t>> buffers(m_threads);
+        std::vector<std::unique_ptr<Compressor>> compressors(m_threads);
+
+        for (size_t first = 0; first < num_blocks; first += m_threads) {
+            const size_t count = std::min(m_threads, num_blocks - first);
+
+            for (size_t i = 0; i < count; i++) {
+                compressors[i] = m_factory();
+                buffers[i].clear();
+            }
+
+            parallel_for(count, m_threads, [&](size_t i) {
+                const size_t from = (first + i) * block_size;
+                const size_t to = std::min(from + block_size, n);
+
+                Input block_input(view.slice(from, to));
+                if (m_restrictions.has_restrictions()) {
+                    block_input = Input(block_input, m_restrictions);
+                }
+
+                Output block_output(buffers[i]);
+                compressors[i]->compress(block_input, block_output);
+            });
+
+            for (size_t i = 0; i < count; i++) {
+                const size_t from = (first + i) * block_size;
+                const size_t to = std::min(from + block_size, n);
+
+                os.write((const char*) buffers[i].data(), buffers[i].size());
+                blocks.push_back(Block { to - from, buffers[i].size() });
+            }
+        }
+
+        write_index(os, blocks);
+    }
+
+    /// Decompresses the container in `input` into `output`.
+    inline void decompress(Input& input, Output& output) {
+        auto view = input.as_view();
+
+        size_t data_size;
+        auto blocks = read_index(view, data_size);
+
+        std::vector<size_t> offsets(blocks.size());
+        {
+            size_t offset = 0;
+            for (size_t i = 0; i < blocks.size(); i++) {
+                offsets[i] = offset;
+                offset += blocks[i].compressed_size;
+            }
+        }
+
+        auto os = output.as_stream();
+
+        std::vector<std::vector<uint8_t>> buffers(m_threads);
+        std::vector<std::unique_ptr<Compressor>> compressors(m_threads);
+
+        for (size_t first = 0; first < blocks.size(); first += m_threads) {
+            const size_t count = std::min(m_threads, blocks.size() - first);
+
+            for (size_t i = 0; i < count; i++) {
+                compressors[i] = m_factory();
+                buffers[i].clear();
+                buffers[i].reserve(blocks[first + i].size);
+            }
+
+            parallel_for(count, m_threads, [&](size_t i) {
+                auto& block = blocks[first + i];
+                const size_t from = offsets[first + i];
+
+                Input block_input(view.slice(from, from + block.compressed_size));
+
+                Output block_output(buffers[i]);
+                if (m_restrictions.has_restrictions()) {
+                    Output restricted_output(block_output, m_restrictions);
+                    compressors[i]->decompress(block_input, restricted_output);
+                } else {
+                    compressors[i]->decompress(block_input, block_output);
+                }
+            });
+
+            for (size_t i = 0; i < count; i++) {
+                if (buffers[i].size() != blocks[first + i].size) {
+                    throw std::runtime_error(
+                        "Decompressed block has an unexpected size");
+                }
+                os.write((const char*) buffers[i].data(), buffers[i].size());
+            }
+        }
+    }
+};
+
+}
+/// \endcond
@@ -4,22 +4,72 @@
 #include <tudocomp/Env.hpp>
 #include <tudocomp/Registry.hpp>
 #include <tudocomp/io.hpp>
+#include <tudocomp/io/Pipe.hpp>
 #include <tudocomp/CreateAlgorithm.hpp>
 #include <tudocomp_driver/Registry.hpp>
 #include <vector>
 #include <memory>
+#include <exception>
+#include <thread>
 
 namespace tdc {
 
+/// Applies the `first` compressor to the input and the `second` compressor
+/// to its output.
+///
+/// By default, the output of the first compressor is buffered completely
+/// before the second one starts. With `pipeline`, both run concurrently
+/// on separate threads and are connected by a \ref io::Pipe that holds at
+/// most `PIPE_BLOCKS` blocks. Compressors that read their input as a single
+/// stream then never hold a full copy of it, while compressors that need a
+/// view or the size of their input fall back to buffering it.
+/// Note that the statistics of the stage run by the additional thread, which
+/// is the first stage when compressing, are not tracked.
 class ChainCompressor: public Compressor {
 public:
     inline static Meta meta() {
         Meta m("compressor", "chain");
         m.option("first").dynamic_compressor();
         m.option("second").dynamic_compressor();
+        m.option("pipeline").dynamic(false);
         return m;
     }
 
+    static constexpr size_t PIPE_BLOCKS = 4;
+
+private:
+    static inline void set_pipeline(ast::Value& value) {
+        if (!value.is_invokation()) return;
+
+        bool is_chain = (value.invokation_name() == "chain");
+        size_t positional = 0;
+        bool has_pipeline = false;
+        for (auto& arg : value.invokation_arguments()) {
+            if (arg.has_keyword()) {
+                has_pipeline |= (arg.keyword() == "pipeline");
+            } else {
+                ++positional;
+            }
+            set_pipeline(arg.value());
+        }
+
+        if (is_chain && !has_pipeline && positional < 3) {
+            value.invokation_arguments().push_back(
+                ast::Arg("pipeline"_v, ast::Value("true")));
+        }
+    }
+
+public:
+    /// Returns the algorithm id `id_string` with `pipeline` enabled for
+    /// all chains in it that do not set it explicitly, including those
+    /// written as `a:b`.
+    static inline std::string pipeline_chains(const std::string& id_string) {
+        ast::Parser p { id_string };
+        auto value = p.parse_value();
+        set_pipeline(value);
+        return value.to_string();
+    }
+
     /// No default construction allowed
     inline ChainCompressor() = delete;
 
@@ -50,6 +100,42 @@ public:
             f(i, o, *compressor, textds_flags);
         };
 
+        if (env().option("pipeline").as_bool()) {
+            io::Pipe pipe(PIPE_BLOCKS);
+            std::exception_ptr first_error;
+
+            std::thread first([&] {
+                io::PipeOStreamBuf buf(pipe);
+                try {
+                    std::ostream stream(&buf);
+                    Output between(stream);
+                    run(input, between, first_algo);
+                } catch (...) {
+                    first_error = std::current_exception();
+                }
+                buf.close();
+            });
+
+            try {
+                io::PipeIStreamBuf buf(pipe);
+                std::istream stream(&buf);
+                Input between = Input::unbuffered(stream);
+                run(between, output, second_algo);
+            } catch (...) {
+                // let the first stage run to completion without blocking
+                pipe.close_reader();
+                first.join();
+                throw;
+            }
+            pipe.close_reader();
+            first.join();
+
+            if (first_error) {
+                std::rethrow_exception(first_error);
+            }
+            return;
+        }
+
         std::vector<uint8_t> between_buf;
         {
             Output between(between_buf);
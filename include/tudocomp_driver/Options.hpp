@@ -1,6 +1,8 @@
 #pragma once
 
 #include <iostream>
+#include <stdexcept>
+#include <string>
 #include <getopt.h>
 
 /// \cond INTERNAL
@@ -11,6 +13,10 @@ constexpr int OPT_HELP   = 1000;
 constexpr int OPT_RAW    = 1001;
 constexpr int OPT_STDIN  = 1002;
 constexpr int OPT_STDOUT = 1003;
+constexpr int OPT_BLOCKS = 1004;
+constexpr int OPT_THREADS = 1005;
+constexpr int OPT_EXTRACT = 1006;
+constexpr int OPT_PIPELINE = 1007;
 
 constexpr option OPTIONS[] = {
     {"algorithm",  required_argument, nullptr, 'a'},
@@ -25,6 +31,10 @@ constexpr option OPTIONS[] = {
     {"raw",        no_argument,       nullptr, OPT_RAW},
     {"usestdin",   no_argument,       nullptr, OPT_STDIN},
     {"usestdout",  no_argument,       nullptr, OPT_STDOUT},
+    {"blocks",     optional_argument, nullptr, OPT_BLOCKS},
+    {"threads",    required_argument, nullptr, OPT_THREADS},
+    {"extract",    required_argument, nullptr, OPT_EXTRACT},
+    {"pipeline",   no_argument,       nullptr, OPT_PIPELINE},
     {"logdir",     required_argument, nullptr, 'L'},
     {"loglevel",   required_argument, nullptr, 'O'},
     {"logverbosity",   required_argument, nullptr, 'V'},
@@ -33,6 +43,28 @@ constexpr option OPTIONS[] = {
 
 class Options {
 public:
+    /// Block size used if --blocks is given without a size.
+    static constexpr size_t DEFAULT_BLOCK_SIZE = size_t(16) << 20;
+
+    /// Parses a size in bytes with an optional K, M or G suffix.
+    static inline size_t parse_size(const std::string& str) {
+        size_t pos;
+        size_t size = std::stoull(str, &pos);
+
+        if (pos + 1 == str.size()) {
+            switch(str[pos]) {
+                case 'K': case 'k': return size << 10;
+                case 'M': case 'm': return size << 20;
+                case 'G': case 'g': return size << 30;
+            }
+        }
+
+        if (pos != str.size()) {
+            throw std::invalid_argument("invalid size: " + str);
+        }
+        return size;
+    }
+
     static inline void print_usage(const std::string& cmd, std::ostream& out) {
         using namespace std;
 
@@ -128,6 +160,33 @@ public:
             << "use stdout for input"
             << endl;
 
+        // --blocks
+        out << right << setw(W_NOSF) << ""
+            << left << setw(W_LF) << "--blocks[=SIZE]"
+            << "(de-)compress independent blocks of SIZE bytes in parallel"
+            << endl << setw(W_INDENT) << "" << "(SIZE may have a K, M or G suffix, default: "
+            << (DEFAULT_BLOCK_SIZE >> 20) << "M)"
+            << endl;
+
+        // --threads
+        out << right << setw(W_NOSF) << ""
+            << left << setw(W_LF) << "--threads=N"
+            << "use N threads for --blocks (default: all hardware threads)"
+            << endl;
+
+        // --extract
+        out << right << setw(W_NOSF) << ""
+            << left << setw(W_LF) << "--extract=OFFSET:LEN"
+            << "decompress only LEN bytes starting at OFFSET"
+            << endl << setw(W_INDENT) << "" << "(implies -d, sizes may have a K, M or G suffix)"
+            << endl;
+
+        // --pipeline
+        out << right << setw(W_NOSF) << ""
+            << left << setw(W_LF) << "--pipeline"
+            << "run the stages of chains (e.g. a:b:c) concurrently"
+            << endl;
+
         // -v, --version
         out << right << setw(W_SF) << "-v" << ", "
             << left << setw(W_LF) << "--version"
@@ -177,6 +236,15 @@ private:
     bool m_stats;
     std::string m_stats_title;
 
+    size_t m_block_size;
+    size_t m_threads;
+
+    bool m_extract;
+    size_t m_extract_from;
+    size_t m_extract_len;
+
+    bool m_pipeline;
+
     std::vector<std::string> m_remaining;
 
 public:
@@ -195,7 +263,13 @@ public:
         m_stdout(false),
         m_raw(false),
         m_decompress(false),
-        m_stats(false)
+        m_stats(false),
+        m_block_size(0),
+        m_threads(0),
+        m_extract(false),
+        m_extract_from(0),
+        m_extract_len(0),
+        m_pipeline(false)
     {
         int c, option_index = 0;
         while((c = getopt_long(argc, argv, "O:V:L:a:dfg:lo:s::v",
@@ -264,6 +338,51 @@ public:
                     m_stdout = true;
                     break;
 
+                case OPT_BLOCKS: // --blocks=[optarg]
+                    try {
+                        m_block_size = optarg ? parse_size(optarg)
+                                              : DEFAULT_BLOCK_SIZE;
+                    } catch(std::exception&) {
+                        m_block_size = 0;
+                    }
+                    if(m_block_size == 0) {
+                        std::cerr << "Invalid block size \"" << optarg << "\"\n";
+                        m_unknown_options = true;
+                    }
+                    break;
+
+                case OPT_THREADS: // --threads=<optarg>
+                    try {
+                        size_t pos;
+                        m_threads = std::stoull(std::string(optarg), &pos);
+                        if(optarg[pos] != 0) throw std::invalid_argument(optarg);
+                    } catch(std::exception&) {
+                        std::cerr << "Invalid thread count \"" << optarg << "\"\n";
+                        m_unknown_options = true;
+                    }
+                    break;
+
+                case OPT_EXTRACT: // --extract=<optarg>
+                    try {
+                        const std::string arg(optarg);
+                        const size_t colon = arg.find(':');
+                        if(colon == std::string::npos) {
+                            throw std::invalid_argument(arg);
+                        }
+                        m_extract_from = parse_size(arg.substr(0, colon));
+                        m_extract_len = parse_size(arg.substr(colon + 1));
+                        m_extract = true;
+                        m_decompress = true;
+                    } catch(std::exception&) {
+                        std::cerr << "Invalid extraction range \"" << optarg << "\"\n";
+                        m_unknown_options = true;
+                    }
+                    break;
+
+                case OPT_PIPELINE: // --pipeline
+                    m_pipeline = true;
+                    break;
+
                 case '?': // unknown option
                     m_unknown_options = true;
                     break;
@@ -302,6 +421,15 @@ public:
     const bool& stats = m_stats;
     const std::string& stats_title = m_stats_title;
 
+    const size_t& block_size = m_block_size;
+    const size_t& threads = m_threads;
+
+    const bool& extract = m_extract;
+    const size_t& extract_from = m_extract_from;
+    const size_t& extract_len = m_extract_len;
+
+    const bool& pipeline = m_pipeline;
+
     const std::vector<std::string>& remaining = m_remaining;
 };
 
@@ -43,7 +43,9 @@ inline void get_monotonic_time(struct timespec *ts){
 /// use in the tudocomp charter for visualization or third party applications.
 class StatPhase {
 private:
-    static StatPhase* s_current;
+    // Phases are tracked per thread, allocations in threads without an
+    // active phase are not tracked
+    static thread_local StatPhase* s_current;
 
     inline static unsigned long current_time_millis() {
         timespec t;
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <exception>
@@ -13,6 +14,8 @@
 #include <tudocomp/io/IOUtil.hpp>
 #include <tudocomp/version.hpp>
 
+#include <tudocomp_driver/BlockContainer.hpp>
+#include <tudocomp_driver/ChainCompressor.hpp>
 #include <tudocomp_driver/Options.hpp>
 #include <tudocomp_driver/Registry.hpp>
 
@@ -38,6 +41,36 @@ static void exit(std::string msg) {
     throw std::runtime_error(msg);
 }
 
+/// Reads an algorithm header terminated by `%`, and slices it off the input.
+static std::string read_header(Input& inp) {
+    std::string header;
+    {
+        auto i_stream = inp.as_stream();
+
+        char c;
+        size_t sanity_size_check = 0;
+        bool err = false;
+        while (i_stream.get(c)) {
+            err = false;
+            if (sanity_size_check > 1023) {
+                err = true;
+                break;
+            } else if (c == '%') {
+                break;
+            } else {
+                header.push_back(c);
+            }
+            sanity_size_check++;
+            err = true;
+        }
+        if (err) {
+            exit("Input did not have an algorithm header!");
+        }
+    }
+    inp = Input(inp, header.size() + 1);
+    return header;
+}
+
 static int bad_usage(const char* cmd, const std::string& message) {
     using namespace std;
     cerr << cmd << ": " << message << endl;
@@ -209,8 +242,23 @@ int main(int argc, char** argv) {
         };
         Selection selection;
 
+        // creates fresh compressor instances for the block container
+        auto create_compressor = [&](const std::string& id_string) {
+            return CompressorFactory([&compressor_registry, id_string]() {
+                auto av = compressor_registry.parse_algorithm_id(id_string);
+                return compressor_registry.select_algorithm(av);
+            });
+        };
+
+        // runs the stages of all chains concurrently if requested
+        auto select_id = [&](std::string&& id_string) {
+            return options.pipeline
+                ? ChainCompressor::pipeline_chains(id_string)
+                : std::move(id_string);
+        };
+
         if (!options.algorithm.empty()) {
-            auto id_string = options.algorithm;
+            auto id_string = select_id(std::string(options.algorithm));
 
             auto av = compressor_registry.parse_algorithm_id(id_string);
             auto input_restrictions = av.textds_flags();
@@ -258,57 +306,55 @@ int main(int argc, char** argv) {
 
             // do the due (or if you like sugar, the Dew is fine too)
             if (do_compress && selection) {
+                const bool use_blocks = options.block_size > 0;
+
                 if (!options.raw) {
                     CHECK(selection.id_string().find('%') == std::string::npos);
 
                     auto o_stream = out.as_stream();
+                    if (use_blocks) {
+                        o_stream << BLOCK_CONTAINER_HEADER << '%';
+                    }
                     o_stream << selection.id_string() << '%';
                 }
 
-                if (selection.input_restrictions().has_restrictions()) {
-                    inp = Input(inp, selection.input_restrictions());
-                }
+                if (use_blocks) {
+                    BlockContainer container(
+                        create_compressor(selection.id_string()),
+                        selection.input_restrictions(),
+                        options.threads);
 
-                //TODO: split?
-                //selection.algorithm_env()->restart_stats("Compress");
-                setup_time = clk::now();
-                selection.compressor().compress(inp, out);
-                comp_time = clk::now();
+                    setup_time = clk::now();
+                    container.compress(inp, out, options.block_size);
+                    comp_time = clk::now();
+                } else {
+                    if (selection.input_restrictions().has_restrictions()) {
+                        inp = Input(inp, selection.input_restrictions());
+                    }
+
+                    //TODO: split?
+                    //selection.algorithm_env()->restart_stats("Compress");
+                    setup_time = clk::now();
+                    selection.compressor().compress(inp, out);
+                    comp_time = clk::now();
+                }
             } else if(options.decompress) {
                 // 3 cases
                 // --decompress                   : read and use header
                 // --decompress --algorithm       : read but ignore header
                 // --decompress --raw --algorithm : no header
 
+                // Without a header, a block container is
+                // indicated by --blocks
                 std::string algorithm_header;
+                bool use_blocks = options.raw && options.block_size > 0;
 
                 if (!options.raw) {
-                    {
-                        // read header
-                        auto i_stream = inp.as_stream();
-
-                        char c;
-                        size_t sanity_size_check = 0;
-                        bool err = false;
-                        while (i_stream.get(c)) {
-                            err = false;
-                            if (sanity_size_check > 1023) {
-                                err = true;
-                                break;
-                            } else if (c == '%') {
-                                break;
-                            } else {
-                                algorithm_header.push_back(c);
-                            }
-                            sanity_size_check++;
-                            err = true;
-                        }
-                        if (err) {
-                            exit("Input did not have an algorithm header!");
-                        }
+                    algorithm_header = read_header(inp);
+                    if (algorithm_header == BLOCK_CONTAINER_HEADER) {
+                        use_blocks = true;
+                        algorithm_header = read_header(inp);
                     }
-                    // Slice off the header
-                    inp = Input(inp, algorithm_header.size() + 1);
                 }
 
                 if (!options.raw && !selection.id_string().empty()) {
@@ -317,7 +363,7 @@ int main(int argc, char** argv) {
                 } else if (!options.raw) {
                     DLOG(INFO) << "Using header id string " << algorithm_header;
 
-                    auto id_string = std::move(algorithm_header);
+                    auto id_string = select_id(std::move(algorithm_header));
                     auto av = compressor_registry.parse_algorithm_id(id_string);
                     auto compressor = compressor_registry.select_algorithm(av);
                     auto input_restrictions = av.textds_flags();
@@ -333,15 +379,53 @@ int main(int argc, char** argv) {
                     DLOG(INFO) << "Using manually given " << selection.id_string();
                 }
 
-                if (selection.input_restrictions().has_restrictions()) {
-                    out = Output(out, selection.input_restrictions());
-                }
+                const bool restricted =
+                    selection.input_restrictions().has_restrictions();
+
+                // decompresses everything to the given output
+                auto decompress_to = [&](Output& output) {
+                    if (use_blocks) {
+                        BlockContainer container(
+                            create_compressor(selection.id_string()),
+                            selection.input_restrictions(),
+                            options.threads);
+
+                        setup_time = clk::now();
+                        container.decompress(inp, output);
+                        comp_time = clk::now();
+                    } else {
+                        if (restricted) {
+                            output = Output(output, selection.input_restrictions());
+                        }
 
-                //TODO: split?
-                //selection.algorithm_env()->restart_stats("Decompress");
-                setup_time = clk::now();
-                selection.compressor().decompress(inp, out);
-                comp_time = clk::now();
+                        //TODO: split?
+                        //selection.algorithm_env()->restart_stats("Decompress");
+                        setup_time = clk::now();
+                        selection.compressor().decompress(inp, output);
+                        comp_time = clk::now();
+                    }
+                };
+
+                if (!options.extract) {
+                    decompress_to(out);
+                } else if (!use_blocks && !restricted) {
+                    setup_time = clk::now();
+                    selection.compressor().extract(
+                        inp, out, options.extract_from, options.extract_len);
+                    comp_time = clk::now();
+                } else {
+                    // positions in block containers and escaped outputs
+                    // are only known after decompressing everything
+                    std::vector<uint8_t> buffer;
+                    {
+                        Output buffer_out(buffer);
+                        decompress_to(buffer_out);
+                    }
+
+                    const size_t from = std::min(options.extract_from, buffer.size());
+                    const size_t len = std::min(options.extract_len, buffer.size() - from);
+                    out.as_stream().write((const char*) buffer.data() + from, len);
+                }
             } else {
                 setup_time = clk::now();
 
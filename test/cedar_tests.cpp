@@ -102,6 +102,28 @@ INSTANTIATE_TEST_CASE_P(InputOutput,
                             InputOutput { "\xff\xff\xff"_v, "255:256:\0"_v }
                         ));
 
+template<class coder_t>
+void roundtrip_lzw_dict_size(const std::string& dict_size) {
+    auto roundtrip = [&](const std::string& str) {
+        test::roundtrip_ex<LZWCompressor<coder_t, lz78::TernaryTrie>>(
+            str, "", "dict_size = \"" + dict_size + "\"");
+    };
+    test::roundtrip_batch(roundtrip);
+    test::on_string_generators(roundtrip, 15);
+
+    // enough factors for many dictionary resets
+    std::string text;
+    for(size_t i = 0; i < 20000; i++) text.push_back('a' + (i * 7919 + i * i * 31) % 1009 % 5);
+    roundtrip(text);
+}
+
+TEST(Lzw, dict_size_roundtrip) {
+    for(std::string dict_size : { "258", "300", "1000" }) {
+        roundtrip_lzw_dict_size<ASCIICoder>(dict_size);
+        roundtrip_lzw_dict_size<BitCoder>(dict_size);
+    }
+}
+
 /*
 TEST(zcedar, base) {
     cedar::da<uint32_t> trie;
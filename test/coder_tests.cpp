@@ -15,6 +15,7 @@
 #include <tudocomp/coders/HuffmanCoder.hpp>
 #include <tudocomp/coders/SLECoder.hpp>
 #include <tudocomp/coders/ArithmeticCoder.hpp>
+#include <tudocomp/coders/ANSCoder.hpp>
 #include <tudocomp/coders/TernaryCoder.hpp>
 
 using namespace tdc;
@@ -226,3 +227,46 @@ TEST(coder, ternary_bits) { test_bits<TernaryCoder>(); }
 TEST(coder, ternary_int) { test_int<TernaryCoder>(); }
 TEST(coder, ternary_str) { test_str<TernaryCoder>(); }
 TEST(coder, ternary_mixed) { test_mixed<TernaryCoder>(); }
+
+TEST(coder, ans_mt) { test_mt<ANSCoder>(); }
+TEST(coder, ans_bits) { test_bits<ANSCoder>(); }
+TEST(coder, ans_int) { test_int<ANSCoder>(); }
+TEST(coder, ans_str) { test_str<ANSCoder>(); }
+TEST(coder, ans_mixed) { test_mixed<ANSCoder>(); }
+
+TEST(coder, ans_blocks) {
+    // values of all kinds spanning several small blocks
+    const std::string word = FibonacciGenerator::generate(16);
+
+    std::stringstream ss;
+    {
+        Output out(ss);
+        ANSCoder::Encoder coder(create_env(ANSCoder::meta(), "block=7"), out, ViewLiterals(word));
+
+        for(size_t i = 0; i < word.length(); i++) {
+            coder.encode(word[i], literal_r);
+            coder.encode(word[i] == 'a', bit_r);
+            coder.encode(i, size_r);
+            coder.encode(i % 200, Range(199));
+            coder.encode(i * i, Range(i, i * i + 1));
+        }
+    }
+
+    std::string result = ss.str();
+    {
+        Input in(result);
+        ANSCoder::Decoder decoder(create_env(ANSCoder::meta(), "block=7"), in);
+
+        size_t i = 0;
+        while(!decoder.eof()) {
+            ASSERT_EQ(word[i], decoder.template decode<uliteral_t>(literal_r));
+            ASSERT_EQ(word[i] == 'a', decoder.template decode<bool>(bit_r));
+            ASSERT_EQ(i, decoder.template decode<size_t>(size_r));
+            ASSERT_EQ(i % 200, decoder.template decode<size_t>(Range(199)));
+            ASSERT_EQ(i * i, decoder.template decode<size_t>(Range(i, i * i + 1)));
+            ++i;
+        }
+
+        ASSERT_EQ(word.length(), i);
+    }
+}
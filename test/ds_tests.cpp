@@ -1,3 +1,4 @@
+#include <cstdlib>
 #include <string>
 #include <vector>
 
@@ -9,8 +10,14 @@
 #include <tudocomp/ds/TextDS.hpp>
 #include <tudocomp/ds/uint_t.hpp>
 #include <tudocomp/ds/bwt.hpp>
+#include <tudocomp/ds/BlockwiseBWT.hpp>
+#include <tudocomp/ds/InverseBWT.hpp>
 #include <tudocomp/ds/SparseISA.hpp>
 #include <tudocomp/ds/CompressedLCP.hpp>
+#include <tudocomp/ds/SAParallel.hpp>
+#include <tudocomp/ds/SAExternal.hpp>
+#include <tudocomp/ds/PLCPExternal.hpp>
+#include <tudocomp/ds/LCPExternal.hpp>
 #include <tudocomp/CreateAlgorithm.hpp>
 #include "test/util.hpp"
 
@@ -66,6 +73,41 @@ void test_bwt(const std::string& str, textds_t& t) {
 	ASSERT_EQ(decoded_string, str);
 }
 
+template<class textds_t>
+void test_blockwise_bwt(const std::string&, textds_t& t) {
+    auto& sa = t.require_sa();
+
+    std::string expected;
+    for(size_t i = 0; i < t.size(); ++i) {
+        expected.push_back(bwt::bwt(t,sa,i));
+    }
+
+    for(size_t blocks : { 1, 4, 64 }) {
+        std::string blockwise;
+        bwt::blockwise_bwt(View(t.text(), t.size()), blocks, [&](View chunk) {
+            blockwise.append((const char*) chunk.data(), chunk.size());
+        });
+        ASSERT_EQ(blockwise, expected) << "blocks = " << blocks;
+    }
+}
+
+template<class textds_t>
+void test_inverse_bwt(const std::string& str, textds_t& t) {
+    auto& sa = t.require_sa();
+
+    std::string bwt;
+    for(size_t i = 0; i < t.size(); ++i) {
+        bwt.push_back(bwt::bwt(t,sa,i));
+    }
+
+    for(size_t threads : { 1, 3 }) {
+        std::string decoded;
+        bwt::inverse_bwt(View(bwt), threads, [&](View chunk) {
+            decoded.append((const char*) chunk.data(), chunk.size());
+        });
+        ASSERT_EQ(decoded, str) << "threads = " << threads;
+    }
+}
 
 // === THE ACTUAL TESTS ===
 template<class textds_t>
@@ -148,6 +190,37 @@ TEST(ds, default_BWT)         { TEST_DS_STRINGCOLLECTION(textds_default_t, test_
 TEST(ds, default_LCP)         { TEST_DS_STRINGCOLLECTION(textds_default_t, test_lcp); }
 TEST(ds, default_ISA)         { TEST_DS_STRINGCOLLECTION(textds_default_t, test_isa); }
 TEST(ds, default_Integration) { TEST_DS_STRINGCOLLECTION(textds_default_t, test_all_ds); }
+TEST(ds, blockwise_BWT)       { TEST_DS_STRINGCOLLECTION(textds_default_t, test_blockwise_bwt); }
+
+TEST(ds, blockwise_BWT_large) {
+    // large enough for multiple blocks and prefix doubling of the sample
+    std::string random, periodic, fibonacci;
+    for(size_t i = 0; i < 100000; i++) random.push_back('a' + (i * 7919 + i * i * 31) % 1009 % 3);
+    for(size_t i = 0; i < 100000; i++) periodic.push_back("abcabcabd"[i % 9]);
+    std::string f0 = "a", f1 = "ab";
+    while(f1.size() < 100000) { f0 = f1 + f0; std::swap(f0, f1); }
+    fibonacci = f1;
+
+    RunTestDS<textds_default_t> runner(test_blockwise_bwt);
+    runner(random);
+    runner(periodic);
+    runner(fibonacci);
+    runner(std::string(100000, 'a'));
+}
+
+TEST(ds, inverse_BWT)         { TEST_DS_STRINGCOLLECTION(textds_default_t, test_inverse_bwt); }
+
+TEST(ds, inverse_BWT_large) {
+    // large enough for more pieces than walks in lockstep, and for all block sizes
+    std::string random, periodic;
+    for(size_t i = 0; i < 600000; i++) random.push_back(1 + (i * 7919 + i * i * 31) % 1009 % 255);
+    for(size_t i = 0; i < 300001; i++) periodic.push_back("abcabcabd"[i % 9]);
+
+    RunTestDS<textds_default_t> runner(test_inverse_bwt);
+    runner(random);
+    runner(periodic);
+    runner(std::string(70000, 'a'));
+}
 
 using textds_sparse_isa_t = TextDS<
     SADivSufSort, PhiFromSA, PLCPFromPhi, LCPFromPLCP, SparseISA<SADivSufSort>>;
@@ -160,3 +233,80 @@ using textds_comp_lcp_t = TextDS<
 
 TEST(ds, comp_lcp_LCP)         { TEST_DS_STRINGCOLLECTION(textds_comp_lcp_t, test_lcp); }
 TEST(ds, comp_lcp_Integration) { TEST_DS_STRINGCOLLECTION(textds_comp_lcp_t, test_all_ds); }
+
+using textds_parallel_sa_t = TextDS<
+    SAParallel, PhiFromSA, PLCPFromPhi, LCPFromPLCP, ISAFromSA>;
+
+TEST(ds, parallel_sa_SA)          { TEST_DS_STRINGCOLLECTION(textds_parallel_sa_t, test_sa); }
+TEST(ds, parallel_sa_Integration) { TEST_DS_STRINGCOLLECTION(textds_parallel_sa_t, test_all_ds); }
+
+TEST(ds, parallel_sa_threads) {
+    for(size_t threads : {2, 3, 8}) {
+        auto runner = [&](const std::string& str) {
+            test::TestInput input = test::compress_input(str);
+            InputView in = input.as_view();
+            auto t = create_algo<textds_parallel_sa_t>(
+                "sa=parallel(threads=" + std::to_string(threads) + ")", in);
+            test_sa(str, t);
+        };
+        test::roundtrip_batch(runner);
+        test::on_string_generators(runner, 11);
+    }
+}
+
+using textds_external_t = TextDS<
+    SAExternal, PhiFromSA, PLCPExternal, LCPExternal, ISAFromSA>;
+
+TEST(ds, external_SA)          { TEST_DS_STRINGCOLLECTION(textds_external_t, test_sa); }
+TEST(ds, external_BWT)         { TEST_DS_STRINGCOLLECTION(textds_external_t, test_bwt); }
+TEST(ds, external_LCP)         { TEST_DS_STRINGCOLLECTION(textds_external_t, test_lcp); }
+TEST(ds, external_Integration) { TEST_DS_STRINGCOLLECTION(textds_external_t, test_all_ds); }
+
+TEST(ds, external_dir) {
+    auto runner = [&](const std::string& str) {
+        test::TestInput input = test::compress_input(str);
+        InputView in = input.as_view();
+        auto t = create_algo<textds_external_t>(
+            "sa=external(dir=\".\"), plcp=external(dir=\".\"), lcp=external(dir=\".\")", in);
+        test_lcp(str, t);
+    };
+    test::roundtrip_batch(runner);
+}
+
+/// Sets an environment variable and restores its previous value on
+/// destruction, also if a test fails early.
+class ScopedEnv {
+    std::string m_name;
+    bool m_was_set;
+    std::string m_saved;
+
+public:
+    inline ScopedEnv(const std::string& name, const std::string& value)
+        : m_name(name) {
+        const char* old = std::getenv(name.c_str());
+        m_was_set = (old != nullptr);
+        if(m_was_set) m_saved = old;
+        setenv(name.c_str(), value.c_str(), 1);
+    }
+
+    inline ~ScopedEnv() {
+        if(m_was_set) {
+            setenv(m_name.c_str(), m_saved.c_str(), 1);
+        } else {
+            unsetenv(m_name.c_str());
+        }
+    }
+};
+
+TEST(ds, external_default_dir) {
+    ScopedEnv tmpdir("TMPDIR", ".");
+
+    std::string str = "abracadabra";
+    test::TestInput input = test::compress_input(str);
+    InputView in = input.as_view();
+    auto t = create_algo<textds_external_t>("", in);
+    ASSERT_EQ(t.require_sa().dir(), ".");
+    ASSERT_EQ(t.require_plcp().dir(), ".");
+    ASSERT_EQ(t.require_lcp().dir(), ".");
+    test_lcp(str, t);
+}
@@ -13,6 +13,7 @@
 
 #include <tudocomp/compressors/esp/HashMapIPD.hpp>
 #include <tudocomp/compressors/esp/DynamicSizeIPD.hpp>
+#include <tudocomp/compressors/esp/CompactIPD.hpp>
 
 using namespace tdc;
 
@@ -470,6 +471,80 @@ TEST(Esp, tree_reducer_roundtrip) {
 
 }
 
+TEST(ESP, threads) {
+    // the grammar does not depend on the amount of threads
+    auto roundtrip = [&](const std::string& str) {
+        auto seq = test::compress<EspCompressor<esp::PlainSLPCoder>>(str);
+        for(std::string threads : { "2", "3", "7" }) {
+            auto par = test::compress<EspCompressor<esp::PlainSLPCoder>>(
+                str, "threads=" + threads);
+            ASSERT_EQ(seq.bytes, par.bytes);
+        }
+        seq.assert_decompress();
+
+        for(bool maximize : { true, false }) {
+            esp::EspContext<test_ipd_t> seq_ctx { nullptr, true };
+            seq_ctx.behavior_metablocks_maximimze_repeating = maximize;
+            auto seq_slp = seq_ctx.generate_grammar(View(str));
+
+            esp::EspContext<test_ipd_t> par_ctx { nullptr, true };
+            par_ctx.behavior_metablocks_maximimze_repeating = maximize;
+            par_ctx.threads = 5;
+            auto par_slp = par_ctx.generate_grammar(View(str));
+
+            ASSERT_EQ(seq_slp.rules, par_slp.rules);
+            ASSERT_EQ(seq_slp.root_rule, par_slp.root_rule);
+            ASSERT_EQ(seq_slp.empty, par_slp.empty);
+        }
+    };
+    test::roundtrip_batch(roundtrip);
+    test::on_string_generators(roundtrip, 15);
+}
+
+TEST(Esp, derive_deep_grammar) {
+    // a chain of rules deeper than the call stack could handle
+    esp::SLP chain;
+    chain.empty = false;
+    chain.rules.push_back({{ 'a', 'b' }});
+    for (size_t i = 1; i < 1000000; i++) {
+        chain.rules.push_back({{ i - 1 + 256, size_t('c') }});
+    }
+    chain.root_rule = chain.rules.size() - 1 + 256;
+
+    auto s = chain.derive_text_s();
+    ASSERT_EQ(s.size(), chain.rules.size() + 1);
+    ASSERT_EQ(s.substr(0, 3), "abc");
+    ASSERT_EQ(s.find_first_not_of('c', 2), std::string::npos);
+
+    // repeated rules are copied, also beyond the buffered window
+    esp::SLP doubling;
+    doubling.empty = false;
+    doubling.rules.push_back({{ 'x', 'y' }});
+    for (size_t i = 1; i < 24; i++) {
+        doubling.rules.push_back({{ i - 1 + 256, i - 1 + 256 }});
+    }
+    doubling.root_rule = doubling.rules.size() - 1 + 256;
+
+    auto lens = doubling.expansion_lengths();
+    ASSERT_EQ(lens.back(), size_t(1) << 24);
+
+    auto d = doubling.derive_text_s();
+    ASSERT_EQ(d.size(), size_t(1) << 24);
+    for (size_t i = 0; i < d.size(); i += 2) {
+        ASSERT_EQ(d[i], 'x');
+        ASSERT_EQ(d[i + 1], 'y');
+    }
+}
+
+TEST(ESP, extract) {
+    test::roundtrip_batch([&](const std::string& str) {
+        test::compress<EspCompressor<esp::PlainSLPCoder>>(str).assert_extract();
+    });
+    test::on_string_generators([&](const std::string& str) {
+        test::compress<EspCompressor<esp::PlainSLPCoder>>(str).assert_extract(9);
+    }, 7);
+}
+
 template<typename T>
 void test_esp() {
  // TODO: ensure ESP code is parametric over input alphabet size and format
@@ -1068,6 +1143,47 @@ TEST(IPD, DynamicSize) {
     auto x = builder<esp::DynamicSizeIPD<esp::StdUnorderedMapIPD>>().instance();
 }
 
+TEST(IPD, compact) {
+    esp::CompactIPD::IPDMap<2, size_t, size_t> map {
+        0, esp::Array<2>(std::array<size_t, 2> {{ size_t(-1), size_t(-1) }})
+    };
+    std::map<std::pair<size_t, size_t>, size_t> expected;
+
+    // the key and value widths grow with the inserted entries
+    size_t counter = 1;
+    for (size_t i = 0; i < 20000; i++) {
+        const size_t a = (i * 7919) % (i + 3);
+        const size_t b = (i % 13 == 0) ? (size_t(1) << 40) + i : i % 101;
+
+        esp::Array<2> key;
+        key.m_data = {{ a, b }};
+        auto val = map.access(key, [&](size_t& v) {
+            if (v == 0) v = counter++;
+        });
+
+        auto& e = expected[std::make_pair(a, b)];
+        if (e == 0) e = val;
+        ASSERT_EQ(e, val);
+    }
+    ASSERT_EQ(map.size(), expected.size());
+
+    size_t visited = 0;
+    map.for_all([&](const esp::Array<2>& key, size_t val) {
+        auto k = std::make_pair(key.m_data[0], key.m_data[1]);
+        ASSERT_EQ(expected.at(k), val);
+        visited++;
+    });
+    ASSERT_EQ(visited, expected.size());
+
+    // the grammar does not depend on the IPD
+    test::roundtrip_batch([&](const std::string& str) {
+        auto std_map = test::compress<EspCompressor<esp::PlainSLPCoder>>(str);
+        auto compact = test::compress<EspCompressor<esp::PlainSLPCoder, esp::CompactIPD>>(str);
+        ASSERT_EQ(std_map.bytes, compact.bytes);
+        compact.assert_decompress();
+    });
+}
+
 TEST(Hashmaps, size) {
     using namespace tdc;
     using namespace esp;
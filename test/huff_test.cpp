@@ -4,6 +4,7 @@
 #include <cstring>
 #include <bitset>
 #include <algorithm>
+#include <random>
 #include <tudocomp/coders/HuffmanCoder.hpp>
 
 using namespace tdc;
@@ -321,3 +322,21 @@ TEST(Coder, binary_output_null_3) {
 
     }, true);
 }
+
+TEST(huffman, long_codewords) {
+    // Fibonacci frequencies yield codewords longer than the decode table
+    std::string text;
+    size_t a = 1, b = 1;
+    for(char c = 'a'; c < 'a' + 20; ++c) {
+        text.append(a, c);
+        const size_t next = a + b;
+        a = b;
+        b = next;
+    }
+    std::mt19937 rng(1);
+    std::shuffle(text.begin(), text.end(), rng);
+
+    const huff::extended_huffmantable table = huff::gen_huffmantable(text);
+    ASSERT_GT(table.longest, huff::DECODE_TABLE_BITS);
+    test_huff(text);
+}
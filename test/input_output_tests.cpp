@@ -2,13 +2,16 @@
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
+#include <thread>
 #include <utility>
+#include <vector>
 
 #include <gtest/gtest.h>
 #include <glog/logging.h>
 
 #include <tudocomp/io/Input.hpp>
 #include <tudocomp/io/Output.hpp>
+#include <tudocomp/io/Pipe.hpp>
 
 #include "test/util.hpp"
 
@@ -54,6 +57,66 @@ TEST(AAAMmap, test) {
     }
 }
 
+TEST(AAAMmap, private_tail) {
+    auto ps = pagesize();
+
+    // File that ends exactly at a page boundary, and one that does not
+    for (size_t file_size : { ps, ps + 3 }) {
+        std::vector<uint8_t> test_vec(file_size, 42);
+
+        auto basename = "mmap_private_tail_test";
+
+        test::write_test_file(basename, test_vec);
+        auto path = test::test_file_path(basename);
+
+        {
+            MMap map { path, MMap::Mode::ReadWrite, file_size + 2 };
+
+            ASSERT_EQ(map.view().slice(0, file_size), View(test_vec));
+            ASSERT_EQ(map.view()[file_size], 0);
+            ASSERT_EQ(map.view()[file_size + 1], 0);
+
+            // writes go to private memory, not the file
+            map.view()[0] = 43;
+            map.view()[file_size + 1] = 44;
+            ASSERT_EQ(map.view()[0], 43);
+            ASSERT_EQ(map.view()[file_size + 1], 44);
+        }
+
+        ASSERT_EQ(View(test::read_test_file(basename)), View(test_vec));
+    }
+}
+
+TEST(AAAMmap, escape_in_place) {
+    auto ps = pagesize();
+    const size_t file_size = 3 * ps + 5;
+
+    // File without bytes to escape, and one with an escaped byte on its
+    // second page, in front of which the mapping is left untouched
+    for (size_t zero_pos : { file_size, ps + 7 }) {
+        std::vector<uint8_t> test_vec(file_size, 'a');
+        std::vector<uint8_t> escaped = test_vec;
+        if (zero_pos < file_size) {
+            test_vec[zero_pos] = 0;
+            escaped[zero_pos] = 0xff;
+            escaped.insert(escaped.begin() + zero_pos + 1, 0xfe);
+        }
+        escaped.push_back(0);
+
+        auto basename = "mmap_escape_in_place_test";
+
+        test::write_test_file(basename, test_vec);
+        auto path = test::test_file_path(basename);
+
+        {
+            Input i = Input(Input(Path { path }), InputRestrictions { { 0 }, true });
+            ASSERT_EQ(View(i.as_view()), View(escaped));
+        }
+
+        ASSERT_EQ(View(test::read_test_file(basename)), View(test_vec));
+    }
+}
+
 const View STREAMBUF_ORIGINAL    = "test\x00\x00\xff\xfe""abcd"_v;
 const View STREAMBUF_NTE         = "test\x00\x00\xff\xfe""abcd\0"_v;
 const View STREAMBUF_ESCAPED_NTE = "test\xfe\xc0\xfe\xc0\xfe\xc1\xfe\xfe""abcd\0"_v;
@@ -143,6 +206,35 @@ TEST(ARestrictedStreamBuf, Output_escaped) {
     ASSERT_EQ(View(sss), STREAMBUF_ORIGINAL);
 }
 
+TEST(ARestrictedStreamBuf, Output_escaped_chunks) {
+    // exceeds the adapter's buffers and mixes single and bulk writes
+    const size_t n = 20000;
+    std::string escaped;
+    std::string original;
+    for(size_t i = 0; i < n; i++) {
+        escaped += STREAMBUF_ESCAPED;
+        original += STREAMBUF_ORIGINAL;
+    }
+
+    std::vector<uint8_t> buf;
+    {
+        Output out(Output(buf), InputRestrictions({0, 0xff}, false));
+        auto os = out.as_stream();
+        const View v(escaped);
+        size_t i = 0;
+        for(size_t step = 1; i < v.size(); step = step * 2 % 1000 + 1) {
+            if(step % 2) {
+                os.put(v[i++]);
+            } else {
+                const size_t len = std::min(step, v.size() - i);
+                os.write(v.substr(i, len));
+                i += len;
+            }
+        }
+    }
+    ASSERT_EQ(View(buf), View(original));
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
@@ -708,3 +800,93 @@ TEST(OnputMatrix, FileTrgt_OutDriverSplit) {
 TEST(OnputMatrix, StreamTrgt_OutDriverSplit) {
     o_matrix_test<StreamTrgt, OutDriverSplit>();
 }
+
+TEST(Pipe, threads) {
+    std::string text;
+    for(size_t i = 0; i < 100000; i++) text += char('a' + i * i % 26);
+
+    // small blocks and capacity make the threads wait for each other
+    Pipe pipe(2);
+    std::thread writer([&] {
+        PipeOStreamBuf buf(pipe, 100);
+        std::ostream os(&buf);
+        for(size_t i = 0; i < text.size(); i += 7) {
+            os << text.substr(i, 7);
+        }
+    });
+
+    PipeIStreamBuf buf(pipe);
+    std::istream is(&buf);
+    std::stringstream ss;
+    ss << is.rdbuf();
+    writer.join();
+
+    ASSERT_EQ(ss.str(), text);
+}
+
+TEST(Pipe, reader_closed) {
+    Pipe pipe(1);
+    std::thread writer([&] {
+        PipeOStreamBuf buf(pipe, 10);
+        std::ostream os(&buf);
+        for(size_t i = 0; i < 1000; i++) os << "0123456789";
+        ASSERT_FALSE(os.good());
+    });
+
+    std::vector<char> block;
+    ASSERT_TRUE(pipe.pop(block));
+    ASSERT_EQ(std::string(block.begin(), block.end()), "0123456789");
+
+    // the writer does not block once the reader is gone
+    pipe.close_reader();
+    writer.join();
+}
+
+TEST(Input, unbuffered_stream) {
+    const std::string text = "abc\0def\xff"_v;
+    {
+        // read directly
+        std::stringstream source(text);
+        Input input = Input::unbuffered(source);
+        std::stringstream ss;
+        ss << input.as_stream().rdbuf();
+        ASSERT_EQ(ss.str(), text);
+        ASSERT_EQ(source.tellg(), std::streampos(text.size()));
+    }
+    {
+        // read directly with restrictions
+        std::stringstream source(text);
+        Input input(Input::unbuffered(source), InputRestrictions({0}, true));
+        std::stringstream ss;
+        ss << input.as_stream().rdbuf();
+        ASSERT_EQ(ss.str(), "abc\xff\xfe" "def\xff\xff\0"_v);
+    }
+    {
+        // buffered by requesting the size first
+        std::stringstream source(text);
+        Input input = Input::unbuffered(source);
+        ASSERT_EQ(input.size(), text.size());
+        for(size_t i = 0; i < 2; i++) {
+            std::stringstream ss;
+            ss << input.as_stream().rdbuf();
+            ASSERT_EQ(ss.str(), text);
+        }
+        ASSERT_EQ(input.as_view(), View(text));
+    }
+    {
+        // the size hint does not buffer the stream
+        std::stringstream source(text);
+        Input input = Input::unbuffered(source);
+        ASSERT_EQ(input.size_hint(), size_t(Input::npos));
+        std::stringstream ss;
+        ss << input.as_stream().rdbuf();
+        ASSERT_EQ(ss.str(), text);
+    }
+    {
+        // but is known once the stream has been buffered
+        std::stringstream source(text);
+        Input input = Input::unbuffered(source);
+        ASSERT_EQ(input.as_view(), View(text));
+        ASSERT_EQ(input.size_hint(), text.size());
+    }
+}
@@ -4,6 +4,12 @@
 #include <tudocomp/Generator.hpp>
 #include <tudocomp/CreateAlgorithm.hpp>
 
+#include <tudocomp/compressors/LZSSLCPCompressor.hpp>
+#include <tudocomp/compressors/LZSSSlidingWindowCompressor.hpp>
+#include <tudocomp/coders/ASCIICoder.hpp>
+#include <tudocomp/coders/BitCoder.hpp>
+#include <tudocomp/coders/ANSCoder.hpp>
+
 #include <tudocomp/compressors/lzss/LZSSCoding.hpp>
 #include <tudocomp/compressors/lzss/LZSSFactors.hpp>
 #include <tudocomp/compressors/lzss/LZSSLiterals.hpp>
@@ -11,6 +17,10 @@
 #include <tudocomp/compressors/lcpcomp/decompress/CompactDec.hpp>
 #include <tudocomp/compressors/lcpcomp/decompress/DecodeQueueListBuffer.hpp>
 #include <tudocomp/compressors/lcpcomp/decompress/MultiMapBuffer.hpp>
+#include <tudocomp/compressors/lcpcomp/decompress/ParallelDec.hpp>
+#include <tudocomp/compressors/lcpcomp/decompress/ScanDec.hpp>
+
+#include "test/util.hpp"
 
 using namespace tdc;
 
@@ -154,8 +164,8 @@ TEST(lzss, decode_back_buffer) {
 }
 
 template<typename T>
-void test_forward_decode_buffer_chain() {
-    T buffer = create_algo<T>("", 12);
+void test_forward_decode_buffer_chain(const std::string& options = "") {
+    T buffer = create_algo<T>(options, 12);
     buffer.decode_literal('b');
     buffer.decode_factor(3, 3);
     buffer.decode_literal('n');
@@ -170,8 +180,8 @@ void test_forward_decode_buffer_chain() {
 }
 
 template<typename T>
-void test_forward_decode_buffer_multiref() {
-    T buffer = create_algo<T>("", 12);
+void test_forward_decode_buffer_multiref(const std::string& options = "") {
+    T buffer = create_algo<T>(options, 12);
     buffer.decode_factor(6, 6);
     buffer.decode_literal('b');
     buffer.decode_factor(9, 3);
@@ -208,3 +218,129 @@ TEST(lzss, decode_forward_ql_buffer_chain) {
 TEST(lzss, decode_forward_ql_buffer_multiref) {
     test_forward_decode_buffer_multiref<lcpcomp::DecodeForwardQueueListBuffer>();
 }
+
+TEST(lzss, decode_forward_parallel_buffer_chain) {
+    test_forward_decode_buffer_chain<lcpcomp::ParallelDec>();
+}
+
+TEST(lzss, decode_forward_parallel_buffer_multiref) {
+    test_forward_decode_buffer_multiref<lcpcomp::ParallelDec>();
+}
+
+template<typename T>
+void test_forward_decode_buffer_deep_chains(const std::string& options) {
+    // a periodic text whose only literals are a single period in the middle,
+    // referenced by self-overlapping factors to its left and right
+    const size_t n = 300000;
+    const size_t period = 7;
+    const size_t mid = n / 2;
+
+    std::string text(n, 0);
+    for(size_t i = 0; i < n; i++) text[i] = 'a' + (i * i + 3) % period % 5;
+
+    T buffer = create_algo<T>(options, n);
+
+    size_t i = 0;
+    for(size_t len = 1; i < mid; len = len % 50 + 1) {
+        len = std::min(len, mid - i);
+        buffer.decode_factor(i + period, len);
+        i += len;
+    }
+    for(; i < mid + period; i++) buffer.decode_literal(text[i]);
+    for(size_t len = 1; i < n; len = len % 50 + 1) {
+        len = std::min(len, n - i);
+        buffer.decode_factor(i - period, len);
+        i += len;
+    }
+    buffer.decode_lazy();
+    buffer.decode_eagerly();
+
+    std::stringstream ss;
+    buffer.write_to(ss);
+    ASSERT_EQ(text, ss.str()) << options;
+}
+
+TEST(lzss, decode_forward_parallel_deep_chains) {
+    for(std::string threads : { "1", "2", "4" }) {
+        test_forward_decode_buffer_deep_chains<lcpcomp::ParallelDec>(
+            "threads=" + threads);
+    }
+}
+
+TEST(lzss, decode_forward_scan_counting) {
+    for(std::string scans : { "0", "1", "6" }) {
+        const std::string options = "scans=" + scans + ", eager=\"counting\"";
+        test_forward_decode_buffer_chain<lcpcomp::ScanDec>(options);
+        test_forward_decode_buffer_multiref<lcpcomp::ScanDec>(options);
+        test_forward_decode_buffer_deep_chains<lcpcomp::ScanDec>(options);
+    }
+}
+
+template<typename coder_t>
+void roundtrip_sliding_window(const std::string& options) {
+    auto roundtrip = [&](const std::string& str) {
+        test::roundtrip_ex<LZSSSlidingWindowCompressor<coder_t>>(str, "", options);
+    };
+    test::roundtrip_batch(roundtrip);
+    test::on_string_generators(roundtrip, 15);
+}
+
+TEST(lzss, sliding_window_roundtrip) {
+    roundtrip_sliding_window<ASCIICoder>("");
+    roundtrip_sliding_window<BitCoder>("");
+    roundtrip_sliding_window<ANSCoder>("");
+    roundtrip_sliding_window<ANSCoder>("coder=ans(block=5)");
+}
+
+TEST(lzss, sliding_window_small) {
+    // windows smaller than the phrases and the input
+    for(std::string window : { "1", "4", "16" }) {
+        roundtrip_sliding_window<BitCoder>("window=" + window);
+        roundtrip_sliding_window<BitCoder>("window=" + window + ", lazy=false");
+        roundtrip_sliding_window<BitCoder>("window=" + window + ", chain=1");
+    }
+}
+
+TEST(lzss, sliding_window_factors) {
+    std::string text;
+    for(size_t i = 0; i < 1000; i++) text += "abcdefgh";
+
+    // the repetitions are found in the window
+    auto result = test::compress<LZSSSlidingWindowCompressor<BitCoder>>(text);
+    ASSERT_LT(result.bytes.size(), text.size() / 16);
+    result.assert_decompress();
+}
+
+TEST(lzss, lcp_strategies) {
+    // all strategies find the same factors
+    auto roundtrip = [&](const std::string& str) {
+        auto naive = test::compress<LZSSLCPCompressor<BitCoder>>(
+            str, "strategy=\"naive\"");
+        auto psv_nsv = test::compress<LZSSLCPCompressor<BitCoder>>(
+            str, "strategy=\"psv_nsv\"");
+        auto lean = test::compress<LZSSLCPCompressor<BitCoder>>(
+            str, "strategy=\"lean\"");
+        ASSERT_EQ(naive.bytes, psv_nsv.bytes);
+        ASSERT_EQ(naive.bytes, lean.bytes);
+
+        // segments are stitched to the sequential parse
+        for(std::string threads : { "2", "3", "7" }) {
+            auto par = test::compress<LZSSLCPCompressor<BitCoder>>(
+                str, "threads=" + threads);
+            ASSERT_EQ(naive.bytes, par.bytes);
+            auto par_lean = test::compress<LZSSLCPCompressor<BitCoder>>(
+                str, "strategy=\"lean\", threads=" + threads);
+            ASSERT_EQ(naive.bytes, par_lean.bytes);
+        }
+        psv_nsv.assert_decompress();
+    };
+    test::roundtrip_batch(roundtrip);
+    test::on_string_generators(roundtrip, 15);
+}
+
+TEST(lzss, extract) {
+    // compressors without random access decompress everything
+    test::roundtrip_batch([&](const std::string& str) {
+        test::compress<LZSSSlidingWindowCompressor<BitCoder>>(str).assert_extract();
+    });
+}
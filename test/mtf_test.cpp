@@ -26,3 +26,42 @@ TEST(MTF, string_test) {
 	std::function<void(std::string&)> func(test_mtf);
 	test::on_string_generators(func,20);
 }
+
+void test_mtf_block(const std::string& input) {
+	uint8_t table[256];
+	std::iota(table, table+256, 0);
+	std::string expected;
+	for(size_t i = 0; i < input.length(); ++i) {
+		expected += mtf_encode_char(static_cast<uint8_t>(input[i]), table, 256);
+	}
+
+	std::string out = input;
+	std::iota(table, table+256, 0);
+	mtf_encode_block(reinterpret_cast<uliteral_t*>(&out[0]), out.size(), table);
+	ASSERT_EQ(out, expected);
+
+	std::iota(table, table+256, 0);
+	mtf_decode_block(reinterpret_cast<uliteral_t*>(&out[0]), out.size(), table);
+	ASSERT_EQ(out, input);
+}
+
+TEST(MTF, block_test) {
+	std::function<void(std::string&)> func(test_mtf_block);
+	test::on_string_generators(func,20);
+
+	// all byte values, including those found in the last entries of the table
+	std::string bytes;
+	for(size_t i = 0; i < 3 * 256; ++i) bytes.push_back(static_cast<char>(255 - (i * 37) % 256));
+	test_mtf_block(bytes);
+}
+
+TEST(MTF, stream_test) {
+	std::string input;
+	for(size_t i = 0; i < 200000; ++i) input.push_back(static_cast<char>((i * i + 7 * i) % 251));
+
+	std::stringstream in(input), encoded, decoded;
+	mtf_encode(in, encoded);
+	ASSERT_EQ(encoded.str().size(), input.size());
+	mtf_decode(encoded, decoded);
+	ASSERT_EQ(decoded.str(), input);
+}
@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+
+#include <tudocomp/compressors/RePairCompressor.hpp>
+#include <tudocomp/compressors/repair/RePairGrammar.hpp>
+#include <tudocomp/coders/ASCIICoder.hpp>
+#include <tudocomp/coders/BitCoder.hpp>
+#include <tudocomp/coders/HuffmanCoder.hpp>
+
+#include "test/util.hpp"
+
+using namespace tdc;
+
+using plain_grammar_t = repair::Grammar<std::vector<repair::sym_t>,
+                                        std::vector<len_compact_t>>;
+using lean_grammar_t = repair::Grammar<DynamicIntVector, DynamicIntVector>;
+
+// expands symbol x of the grammar
+static void expand(repair::sym_t x, const repair::grammar_t& g, std::string& out) {
+    if(x < 256) {
+        out.push_back(char(x));
+    } else {
+        expand(repair::left(g[x - 256]), g, out);
+        expand(repair::right(g[x - 256]), g, out);
+    }
+}
+
+template<typename grammar_t>
+static void check_grammar(const std::string& str) {
+    grammar_t g(View(str), str.size(), 256, SIZE_MAX);
+
+    std::string decoded;
+    auto seq = g.sequence();
+    for(auto x : seq) expand(x, g.grammar(), decoded);
+    ASSERT_EQ(str, decoded);
+
+    // no digram occurs twice without overlapping in the final sequence
+    std::map<repair::digram_t, size_t> last;
+    for(size_t i = 0; i + 1 < seq.size(); i++) {
+        auto di = repair::digram(seq[i], seq[i+1]);
+        auto it = last.find(di);
+        if(it != last.end()) {
+            ASSERT_EQ(it->second + 1, i) << "digram occurs twice";
+        } else {
+            last[di] = i;
+        }
+    }
+}
+
+TEST(repair, grammar) {
+    for(std::string str : { "", "a", "aa", "aaa", "aaaa", "abab", "abcabcabc",
+                            "abracadabra", "aaaaaaaaaaaaaaaaaaaaaaaaaaa" }) {
+        check_grammar<plain_grammar_t>(str);
+        check_grammar<lean_grammar_t>(str);
+    }
+
+    test::on_string_generators([](const std::string& str) {
+        check_grammar<plain_grammar_t>(str);
+        check_grammar<lean_grammar_t>(str);
+    }, 15);
+}
+
+TEST(repair, runs) {
+    // a run of 2^k characters becomes k-1 rules, the last digram is unique
+    const std::string str(1024, 'a');
+    plain_grammar_t g(View(str), str.size(), 256, SIZE_MAX);
+    ASSERT_EQ(g.grammar().size(), 9U);
+    ASSERT_EQ(g.sequence().size(), 2U);
+}
+
+template<typename coder_t>
+void roundtrip_repair(const std::string& options) {
+    auto roundtrip = [&](const std::string& str) {
+        test::roundtrip_ex<RePairCompressor<coder_t>>(str, "", options);
+    };
+    test::roundtrip_batch(roundtrip);
+    test::on_string_generators(roundtrip, 15);
+}
+
+TEST(repair, roundtrip) {
+    roundtrip_repair<ASCIICoder>("");
+    roundtrip_repair<BitCoder>("");
+    roundtrip_repair<HuffmanCoder>("");
+    roundtrip_repair<BitCoder>("lean=true");
+    roundtrip_repair<BitCoder>("max_rules=3");
+}
+
+TEST(repair, extract) {
+    for(std::string options : { "", "max_rules=3" }) {
+        test::roundtrip_batch([&](const std::string& str) {
+            test::compress<RePairCompressor<BitCoder>>(str, options).assert_extract();
+        });
+        test::on_string_generators([&](const std::string& str) {
+            test::compress<RePairCompressor<BitCoder>>(str, options).assert_extract(9);
+        }, 7);
+    }
+}
@@ -19,3 +19,48 @@ TEST(RLE, string_test) {
 	std::function<void(std::string&)> func(test_rle);
 	test::on_string_generators(func,20);
 }
+
+// the character-wise encoding, which the block-wise one must reproduce
+std::string rle_reference(const std::string& input, size_t offset) {
+	std::stringstream out;
+	for(size_t i = 0; i < input.size();) {
+		out << input[i];
+		if(i + 1 < input.size() && input[i+1] == input[i]) {
+			size_t j = i + 2;
+			while(j < input.size() && input[j] == input[i]) ++j;
+			out << input[i];
+			write_vbyte(out, j - i - 2 + offset);
+			i = j;
+		} else {
+			++i;
+		}
+	}
+	return out.str();
+}
+
+void test_rle_blocks(const std::string& input, size_t offset) {
+	std::stringstream in{input}, encoded, decoded;
+	rle_encode(in, encoded, offset);
+	ASSERT_EQ(encoded.str(), rle_reference(input, offset));
+	rle_decode(encoded, decoded, offset);
+	ASSERT_EQ(decoded.str(), input);
+}
+
+TEST(RLE, block_test) {
+	// runs of all lengths, also across the block boundaries of input and output
+	for(size_t seed : { 1, 2, 3 }) {
+		std::string input;
+		size_t x = seed;
+		while(input.size() < 5 * rle::BLOCK_SIZE) {
+			x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+			const size_t len = (x >> 40) % 4 == 0 ? (x >> 20) % 3000 : (x >> 20) % 4;
+			input.append(len + 1, static_cast<char>((x >> 50) % 5));
+		}
+		test_rle_blocks(input, 0);
+		test_rle_blocks(input, 3);
+	}
+	test_rle_blocks(std::string(3 * rle::BLOCK_SIZE + 5, 'a'), 0);
+	test_rle_blocks(std::string(1, 'a'), 0);
+	test_rle_blocks(std::string(2, 'a'), 0);
+	test_rle_blocks("abcdefghijklmnopqrstuvwxyzz", 0);
+}
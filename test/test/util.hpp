@@ -405,6 +405,32 @@ public:
         ASSERT_EQ(orginal_text, decompressed_text);
     }
 
+    /// Decompresses only `len` characters starting at `from`.
+    std::string extract(size_t from, size_t len) {
+        std::vector<uint8_t> decoded_buffer;
+        {
+            Input text_in = Input::from_memory(bytes);
+            Output decoded_out = Output::from_memory(decoded_buffer);
+
+            auto compressor = create_algo_with_registry<C>(options, m_registry);
+            compressor.extract(text_in, decoded_out, from, len);
+        }
+        return std::string(decoded_buffer.begin(), decoded_buffer.end());
+    }
+
+    /// Checks the extraction of all substrings of the original text up
+    /// to length `max_len`, and of the whole text.
+    void assert_extract(size_t max_len = 4) {
+        const size_t n = orginal_text.size();
+        for(size_t from = 0; from <= n; from++) {
+            for(size_t len = 0; len <= max_len; len++) {
+                ASSERT_EQ(orginal_text.substr(from, len), extract(from, len))
+                    << "from = " << from << ", len = " << len;
+            }
+        }
+        ASSERT_EQ(orginal_text, extract(0, n + 1));
+    }
+
     void assert_decompress_bytes() {
         std::vector<uint8_t> decompressed_bytes;
         {
@@ -8,7 +8,9 @@
 
 #include <tudocomp/AlgorithmStringParser.hpp>
 #include <tudocomp/Env.hpp>
+#include <tudocomp/CreateAlgorithm.hpp>
 #include <tudocomp_driver/Registry.hpp>
+#include <tudocomp_driver/ChainCompressor.hpp>
 
 #include "test/util.hpp"
 #include "test/driver_util.hpp"
@@ -231,3 +233,209 @@ TEST(Registry, chain_sugar) {
                 ", algo2)"
         ", algo3(\"asdf\"))");
 }
+
+TEST(TudocompDriver, blocks) {
+    std::string text = "abcabcabcabcxyzxyzxyzabc\0\0abcabcabcdddddddddd"_v;
+    test::write_test_file("_blocks_test.txt", text);
+
+    auto in = test::test_file_path("_blocks_test.txt");
+    auto comp = test::test_file_path("_blocks_test.tdc");
+    auto decomp = test::test_file_path("_blocks_test.decomp.txt");
+
+    for (std::string algo : { "lz78(ascii)", "lzw(ascii)", "lzss_lcp(ascii)" }) {
+        for (std::string block_size : { "7", "16", "1K" }) {
+            test::remove_test_file("_blocks_test.tdc");
+            test::remove_test_file("_blocks_test.decomp.txt");
+
+            auto comp_out = driver_test::driver(
+                "--blocks=" + block_size + " --threads=3 --algorithm "
+                + driver_test::shell_escape(algo)
+                + " --output " + driver_test::shell_escape(comp)
+                + " " + driver_test::shell_escape(in));
+            ASSERT_TRUE(test::test_file_exists("_blocks_test.tdc")) << comp_out;
+
+            std::string compressed = test::read_test_file("_blocks_test.tdc");
+            ASSERT_EQ(compressed.find("#blocks%" + algo + "%"), 0u);
+
+            auto decomp_out = driver_test::driver(
+                "--decompress --threads=2"
+                " --output " + driver_test::shell_escape(decomp)
+                + " " + driver_test::shell_escape(comp));
+            ASSERT_TRUE(test::test_file_exists("_blocks_test.decomp.txt")) << decomp_out;
+
+            ASSERT_EQ(test::read_test_file("_blocks_test.decomp.txt"), text)
+                << algo << " with block size " << block_size;
+        }
+    }
+}
+
+TEST(TudocompDriver, pipeline) {
+    std::string text;
+    for (size_t i = 0; i < 100000; i++) {
+        text.push_back('a' + (i * i) % 251 % 11);
+    }
+    test::write_test_file("_pipeline_test.txt", text);
+
+    auto in = test::test_file_path("_pipeline_test.txt");
+    auto decomp = test::test_file_path("_pipeline_test.decomp.txt");
+
+    const std::string algo = "bwt:rle:mtf:encode(huff)";
+
+    auto compress = [&](const std::string& name, const std::string& flags) {
+        test::remove_test_file(name);
+        auto comp_out = driver_test::driver(
+            flags + "--algorithm " + driver_test::shell_escape(algo)
+            + " --output " + driver_test::shell_escape(test::test_file_path(name))
+            + " " + driver_test::shell_escape(in));
+        EXPECT_TRUE(test::test_file_exists(name)) << comp_out;
+        return test::read_test_file(name);
+    };
+
+    std::string buffered = compress("_pipeline_test.tdc", "");
+    std::string pipelined = compress("_pipeline_test.pipelined.tdc", "--pipeline ");
+
+    // the header enables the pipeline for every chain, the data is the same
+    auto header_end = pipelined.find('%');
+    ASSERT_NE(header_end, std::string::npos);
+    auto header = pipelined.substr(0, header_end);
+    ASSERT_EQ(header, ChainCompressor::pipeline_chains(algo));
+    ASSERT_EQ(pipelined.substr(header_end), buffered.substr(buffered.find('%')));
+
+    for (std::string flags : { "", "--pipeline " }) {
+        test::remove_test_file("_pipeline_test.decomp.txt");
+        auto decomp_out = driver_test::driver(
+            flags + "--decompress --output " + driver_test::shell_escape(decomp)
+            + " " + driver_test::shell_escape(
+                test::test_file_path("_pipeline_test.pipelined.tdc")));
+        ASSERT_TRUE(test::test_file_exists("_pipeline_test.decomp.txt")) << decomp_out;
+        ASSERT_EQ(test::read_test_file("_pipeline_test.decomp.txt"), text);
+    }
+}
+
+TEST(ChainCompressor, pipeline_chains) {
+    ASSERT_EQ(ChainCompressor::pipeline_chains("lz78(ascii)"), "lz78(ascii)");
+    ASSERT_EQ(ChainCompressor::pipeline_chains("bwt:rle:mtf"),
+        "chain(chain(bwt, rle, pipeline = \"true\"), mtf, pipeline = \"true\")");
+    ASSERT_EQ(ChainCompressor::pipeline_chains("chain(rle, mtf, pipeline = false)"),
+        "chain(rle, mtf, pipeline = \"false\")");
+    ASSERT_EQ(ChainCompressor::pipeline_chains("chain(rle, mtf, false)"),
+        "chain(rle, mtf, \"false\")");
+}
+
+TEST(ChainCompressor, pipeline) {
+    using namespace tdc_algorithms;
+
+    // larger than the blocks held by the pipe
+    std::string text;
+    for (size_t i = 0; i < 300000; i++) {
+        text.push_back('a' + (i * 7919 + i * i * 31) % 1009 % 7);
+        if (i % 97 == 0) text.append(i % 13, 'z');
+    }
+
+    // the reading stage of either direction streams its input or buffers it
+    for (std::string algo : {
+            "mtf, rle", "rle, mtf",
+            "lz78, lzw", "lzw, lz78",
+            "lzss(bit), lz78u(streaming(bit), bit)",
+            "lz78u(streaming(bit), bit), lzss(bit)",
+            "rle, bwt", "bwt, rle",
+            "mtf, lzss_lcp(bit)", "lzss_lcp(bit), mtf" }) {
+        auto buffered = test::compress<ChainCompressor>(
+            text, algo + ", pipeline = false", COMPRESSOR_REGISTRY);
+        auto pipelined = test::compress<ChainCompressor>(
+            text, algo + ", pipeline = true", COMPRESSOR_REGISTRY);
+
+        ASSERT_EQ(pipelined.str, buffered.str) << algo;
+        buffered.assert_decompress();
+        pipelined.assert_decompress();
+    }
+}
+
+TEST(ChainCompressor, pipeline_errors) {
+    using namespace tdc_algorithms;
+
+    // an invalid LZW code, followed by enough data to fill the pipe
+    std::string corrupted = "97:300:";
+    corrupted.append(1 << 20, '1');
+
+    auto decompress = [&](const std::string& algo) {
+        auto chain = create_algo_with_registry<ChainCompressor>(
+            algo + ", pipeline = true", COMPRESSOR_REGISTRY);
+        std::vector<uint8_t> decompressed;
+        Input input = Input::from_memory(corrupted);
+        Output output = Output::from_memory(decompressed);
+        chain.decompress(input, output);
+    };
+
+    // the reading stage fails while the writing stage is blocked
+    ASSERT_THROW(decompress("lzw(ascii), noop"), std::runtime_error);
+    // the writing stage fails and its error is passed on
+    ASSERT_THROW(decompress("noop, lzw(ascii)"), std::runtime_error);
+}
+
+/// Provides a text in small blocks, and records the amount of output that
+/// has been written whenever the next block is requested.
+class WatchedStreamBuf: public std::streambuf {
+    static constexpr size_t BLOCK_SIZE = 1024;
+
+    std::string& m_text;
+    const std::vector<uint8_t>& m_output;
+    size_t m_pos = 0;
+
+public:
+    std::vector<size_t> output_sizes;
+
+    inline WatchedStreamBuf(std::string& text, const std::vector<uint8_t>& output):
+        m_text(text), m_output(output) {}
+
+protected:
+    virtual int_type underflow() override {
+        if (m_pos == m_text.size()) {
+            return traits_type::eof();
+        }
+        const size_t len = std::min(BLOCK_SIZE, m_text.size() - m_pos);
+        char* block = &m_text[m_pos];
+        setg(block, block, block + len);
+        m_pos += len;
+        output_sizes.push_back(m_output.size());
+        return traits_type::to_int_type(*block);
+    }
+};
+
+TEST(ChainCompressor, streaming_stages) {
+    using namespace tdc_algorithms;
+
+    std::string text;
+    for (size_t i = 0; i < 1000000; i++) {
+        text.push_back('a' + (i * 7919 + i * i * 31) % 1009 % 26);
+    }
+
+    // the stages that read their input as a stream write output before
+    // the input of a pipe has been read completely
+    for (std::string algo : { "lz78", "lzw" }) {
+        for (bool unbuffered : { false, true }) {
+            std::vector<uint8_t> compressed;
+            WatchedStreamBuf buf(text, compressed);
+            std::istream stream(&buf);
+            {
+                auto compressor = COMPRESSOR_REGISTRY.select(algo);
+                Input input = unbuffered ? Input::unbuffered(stream) : Input(stream);
+                Output output(compressed);
+                compressor->compress(input, output);
+            }
+            ASSERT_EQ(buf.output_sizes.back() > 0, unbuffered) << algo;
+
+            // decompress from an unbuffered stream as well
+            std::string compressed_str(compressed.begin(), compressed.end());
+            std::stringstream compressed_stream(compressed_str);
+            std::vector<uint8_t> decompressed;
+            {
+                auto compressor = COMPRESSOR_REGISTRY.select(algo);
+                Input input = Input::unbuffered(compressed_stream);
+                Output output(decompressed);
+                compressor->decompress(input, output);
+            }
+            ASSERT_EQ(View(decompressed), View(text)) << algo;
+        }
+    }
+}
@@ -1,8 +1,10 @@
 #include <algorithm>
 #include <iostream>
+#include <random>
 #include <sstream>
 #include <stdexcept>
 #include <utility>
+#include <vector>
 
 #include <gtest/gtest.h>
 #include <glog/logging.h>
@@ -726,6 +728,89 @@ TEST(IO, bits_eof) {
     }
 }
 
+TEST(IO, bits_words) {
+    // write integers of all widths, spanning several buffer words and
+    // input chunks, and compare against a bitwise reference encoding
+    std::mt19937_64 rng(42);
+    std::vector<std::pair<uint64_t, size_t>> values;
+    for(size_t i = 0; i < 20000; i++) {
+        const size_t bits = rng() % 65;
+        const uint64_t v = rng();
+        values.emplace_back(bits ? v >> (64 - bits) : 0, bits);
+    }
+
+    std::vector<bool> ref;
+    for(auto& p : values) {
+        for(size_t j = p.second; j > 0; j--) ref.push_back((p.first >> (j - 1)) & 1);
+        for(size_t j = 0; j < p.second; j++) ref.push_back(0); // unary
+        ref.push_back(1);
+    }
+
+    std::string expected;
+    {
+        uint8_t byte = 0;
+        for(size_t i = 0; i < ref.size(); i++) {
+            byte |= uint8_t(ref[i]) << (7 - i % 8);
+            if(i % 8 == 7) { expected.push_back(char(byte)); byte = 0; }
+        }
+        const uint8_t set = ref.size() % 8;
+        if(set < 6) {
+            expected.push_back(char(byte | set));
+        } else {
+            expected.push_back(char(byte));
+            expected.push_back(char(set));
+        }
+    }
+
+    std::ostringstream ss_result;
+    {
+        Output output(ss_result);
+        BitOStream out(output);
+        for(auto& p : values) {
+            out.write_int(p.first, p.second);
+            out.write_unary(p.second);
+        }
+    }
+    ASSERT_EQ(expected, ss_result.str());
+
+    Input input(expected);
+    BitIStream in(input);
+    for(auto& p : values) {
+        ASSERT_FALSE(in.eof());
+        ASSERT_EQ(p.first, in.read_int<uint64_t>(p.second));
+        ASSERT_EQ(p.second, in.read_unary<size_t>());
+    }
+    ASSERT_TRUE(in.eof());
+    ASSERT_EQ(0U, in.read_int<uint64_t>(64));
+}
+
+TEST(IO, bits_elias) {
+    std::vector<size_t> values;
+    for(size_t i = 0; i < 1000; i++) values.push_back(i * i * i + i);
+    values.push_back(size_t(1) << 63);
+
+    std::ostringstream ss_result;
+    {
+        Output output(ss_result);
+        BitOStream out(output);
+        for(auto v : values) {
+            out.write_elias_gamma(v);
+            out.write_elias_delta(v);
+            out.write_unary(v % 200);
+        }
+    }
+
+    std::string result = ss_result.str();
+    Input input(result);
+    BitIStream in(input);
+    for(auto v : values) {
+        ASSERT_EQ(v, in.read_elias_gamma<size_t>());
+        ASSERT_EQ(v, in.read_elias_delta<size_t>());
+        ASSERT_EQ(v % 200, in.read_unary<size_t>());
+    }
+    ASSERT_TRUE(in.eof());
+}
+
 TEST(View, construction) {
     static const uint8_t DATA[3] = { 'f', 'o', 'o' };
 